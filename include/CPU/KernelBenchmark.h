@@ -0,0 +1,21 @@
+#pragma once
+#include "WideBVH.h"
+#include <memory>
+#include <random>
+
+// times every supported instruction set on the same random rays against sphere groups and wide nodes of the scene,
+// checks that SIMD kernels give the same answers as scalar ones and prints throughput with speedup over scalar
+class KernelBenchmark {
+ private:
+  std::shared_ptr<WideBVH> _wideBVH;
+  std::vector<Ray> _rays;
+  std::vector<glm::vec3> _inverseDirections;
+
+  // tests per second and checksum of the results, checksum must be the same for every instruction set
+  std::tuple<float, uint64_t> _benchmarkSpheres(Kernels& kernels, int repeats);
+  std::tuple<float, uint64_t> _benchmarkBoxes(Kernels& kernels, int repeats);
+
+ public:
+  KernelBenchmark(std::shared_ptr<Scene> scene, int rays);
+  void run(int repeats);
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "Scene.h"
+#include <string>
+
+// SSE4 and AVX2 kernels exist only in x86 builds, other architectures use scalar ones
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_X86
+#endif
+
+// SIMD kernels get their instruction set per function, not per file, so inline and template code of glm and std
+// emitted in their files stays baseline and can be shared with the rest of the binary; MSVC needs no flags for
+// intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CPU_TARGET_SSE4
+#define CPU_TARGET_AVX2
+#endif
+
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 direction;
+};
+
+// 8 spheres in SoA layout, unused lanes have huge negative squared radius, so they are never hit
+struct alignas(32) SphereLeaf {
+  float centerX[8], centerY[8], centerZ[8];
+  float radius2[8];
+  int sphere[8];
+};
+
+// 8 child boxes in SoA layout, unused lanes are degenerate boxes far away, so they are never hit
+struct alignas(32) WideNode {
+  float minX[8], minY[8], minZ[8];
+  float maxX[8], maxY[8], maxZ[8];
+  // index of child node, ~index of leaf for leaves
+  int child[8];
+};
+
+enum class InstructionSet { SCALAR = 0, SSE4 = 1, AVX2 = 2 };
+
+// one ray against 8 spheres: lane of the closest hit inside [tMin, tMax] or -1, distance of the hit goes to t;
+// of lanes hit at the same distance the first one is returned by every instruction set
+using HitSpheresKernel = int (*)(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t);
+// one ray against 8 boxes: bit mask of boxes overlapping [tMin, tMax], entry distances go to tEntry
+using HitBoxesKernel = uint32_t (*)(const Ray& ray,
+                                    const glm::vec3& inverseDirection,
+                                    const WideNode& node,
+                                    float tMin,
+                                    float tMax,
+                                    float* tEntry);
+
+struct Kernels {
+  InstructionSet instructionSet;
+  HitSpheresKernel hitSpheres;
+  HitBoxesKernel hitBoxes;
+};
+
+// the widest instruction set supported by both CPU and OS, from CPUID and XGETBV
+InstructionSet detectInstructionSet();
+std::string getInstructionSetName(InstructionSet instructionSet);
+// kernels of the requested set, falls back to narrower ones if CPU doesn't support it or binary is built without it
+Kernels getKernels(InstructionSet instructionSet);
+
+// implementations, SIMD ones are compiled for their instruction set and must be called only if it's detected
+int hitSpheresScalar(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t);
+uint32_t hitBoxesScalar(const Ray& ray,
+                        const glm::vec3& inverseDirection,
+                        const WideNode& node,
+                        float tMin,
+                        float tMax,
+                        float* tEntry);
+CPU_TARGET_SSE4 int hitSpheresSSE4(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t);
+CPU_TARGET_SSE4 uint32_t hitBoxesSSE4(const Ray& ray,
+                                      const glm::vec3& inverseDirection,
+                                      const WideNode& node,
+                                      float tMin,
+                                      float tMax,
+                                      float* tEntry);
+CPU_TARGET_AVX2 int hitSpheresAVX2(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t);
+CPU_TARGET_AVX2 uint32_t hitBoxesAVX2(const Ray& ray,
+                                      const glm::vec3& inverseDirection,
+                                      const WideNode& node,
+                                      float tMin,
+                                      float tMax,
+                                      float* tEntry);
@@ -0,0 +1,130 @@
+#pragma once
+#include "Scene.h"
+#include "Sobol.h"
+#include "TileScheduler.h"
+#include "WideBVH.h"
+#include <memory>
+#include <array>
+
+struct HitRecord {
+  glm::vec3 normal;
+  glm::vec3 point;
+  float t;
+  UniformMaterial material;
+  bool frontFace;
+  int sphere;
+};
+
+// scrambling seed of the pixel and index of the current sample inside it, see SobolSample in raytracing.comp
+struct SampleState {
+  uint32_t pixelSeed;
+  uint32_t sampleIndex;
+};
+
+// how rays of one bounce are traversed: one by one, in packets of neighbor rays sharing a stack, or as a stream
+// filtered node by node; AUTO picks packets or stream every bounce from coherence of the rays
+enum class TraversalMode { AUTO = 0, SINGLE = 1, PACKET = 2, STREAM = 3 };
+
+// path advanced bounce by bounce, so all paths of a tile can be traversed together
+struct PathState {
+  Ray ray;
+  glm::vec3 inverseDirection;
+  SampleState sample;
+  // closest hit found by traversal, sphere is -1 if ray escapes
+  float t;
+  int sphere;
+  glm::vec3 radiance;
+  glm::vec3 throughput;
+  // pdf of the last BSDF sample for MIS, 0 for camera ray and specular bounces
+  float bsdfPdf;
+  glm::vec3 previousPoint, previousNormal;
+  // guide values of the camera ray hit for the denoiser, the same as primary ones of raytracing.comp
+  glm::vec3 primaryAlbedo, primaryNormal;
+  float primaryDepth;
+  int depth;
+  // index inside the tile
+  int pixel;
+};
+
+// CPU port of raytracing.comp: the same scene, camera, Sobol sampling, materials, BVH and next event estimation,
+// so with the same settings it converges to the same image as GPU and can be used as reference for it;
+// GPU only accelerations (ReSTIR, radiance cache, path guiding) are not ported
+class PathTracer {
+ private:
+  std::shared_ptr<Scene> _scene;
+  std::shared_ptr<TileScheduler> _scheduler;
+  // SIMD kernels traverse wide BVH, scalar ones keep the threaded BVH of the scene like GPU does
+  std::shared_ptr<WideBVH> _wideBVH;
+  Kernels _kernels;
+  std::vector<uint32_t> _sobol;
+  int _sobolSamples;
+  // every worker counts own rays, padded so counters don't share cache lines
+  struct alignas(64) RayCounter {
+    uint64_t rays;
+    // rays traced by SINGLE, PACKET and STREAM traversal
+    uint64_t traversals[3];
+  };
+  std::vector<RayCounter> _rays;
+  std::tuple<int, int> _resolution;
+  // rows are stored top to bottom, the same as result texture of ComputePart
+  std::vector<glm::vec4> _result;
+  // the same as albedo and normal-depth textures of ComputePart, ReSTIR part of albedo alpha is always 0
+  std::vector<glm::vec4> _albedo, _normalDepth;
+
+  int _aaSamples = 4;
+  int _maxDepth = 50;
+  bool _useBVH = true;
+  bool _useNEE = true;
+  bool _useLightBVH = true;
+  int _tileSize = 16;
+  TraversalMode _traversal = TraversalMode::AUTO;
+  // average direction length of packets above which bounce is traced by packets, camera rays are about 1
+  float _packetCoherence = 0.9f;
+  float _time = 0.f;
+  float _mrays = 0.f;
+
+  glm::vec4 _sobolSample(SampleState& state, uint32_t dimensionSet);
+  bool _hitWorld(Ray ray, float tMin, float tMax, HitRecord& hitRecord);
+  // closest sphere of wide BVH (or of all sphere groups without BVH), -1 if nothing is hit
+  int _hitWorldWide(Ray& ray, float tMin, float& tMax);
+  bool _occluded(Ray ray, float tMin, float tMax);
+  bool _occludedWide(Ray& ray, float tMin, float tMax);
+  float _lightPdf(glm::vec3 point, glm::vec3 normal, UniformSphere& light);
+  glm::vec3 _sampleLight(HitRecord& hitRecord, glm::vec3 u, uint64_t& rays);
+  TraversalMode _chooseTraversal(std::vector<PathState>& paths, std::vector<int>& active);
+  void _intersectPacket(std::vector<PathState>& paths, const int* indices, int count);
+  void _traverseStream(std::vector<PathState>& paths,
+                       int node,
+                       int begin,
+                       int end,
+                       std::vector<int>& rays,
+                       std::vector<uint32_t>& masks);
+  void _intersect(std::vector<PathState>& paths, std::vector<int>& active, TraversalMode mode, RayCounter& counter);
+  // one bounce of raytracing.comp rayColor loop, false if path is terminated
+  bool _shade(PathState& path, uint64_t& rays);
+  void _renderTile(Tile tile, UniformCamera& camera, std::tuple<int, int> extent, uint32_t frameIndex, int worker);
+
+ public:
+  PathTracer(std::shared_ptr<Scene> scene, std::shared_ptr<TileScheduler> scheduler, std::tuple<int, int> resolution);
+  void setAASamples(int aaSamples);
+  void setMaxDepth(int maxDepth);
+  void setBVH(bool useBVH);
+  void setNEE(bool useNEE);
+  void setLightBVH(bool useLightBVH);
+  // detected at construction, can be lowered to compare kernels, wider sets than detected one are clamped
+  void setInstructionSet(InstructionSet instructionSet);
+  InstructionSet getInstructionSet();
+  void setTraversal(TraversalMode traversal);
+  // share of the last render rays traced by SINGLE, PACKET and STREAM traversal
+  std::array<float, 3> getTraversalShares();
+  // only extent part of the image is rendered, frame index shifts samples like in ComputePart;
+  // rows below the first one (counted from the bottom like invocation y of the shader) are left untouched
+  void render(UniformCamera camera, std::tuple<int, int> extent, uint32_t frameIndex, int firstRow = 0);
+  std::vector<glm::vec4>& getResult();
+  std::vector<glm::vec4>& getAlbedo();
+  std::vector<glm::vec4>& getNormalDepth();
+  // wall time of the last render in milliseconds
+  float getTime();
+  // camera, bounce and shadow rays of the last render
+  float getMraysPerSecond();
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <tuple>
+
+struct Tile {
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+// persistent worker threads processing image tiles; every worker starts with a contiguous range of tiles and
+// idle workers steal from the far end of the others' ranges, so uneven tiles (sky vs glass) don't leave cores idle
+class TileScheduler {
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Tile> tiles;
+  };
+  std::vector<std::thread> _threads;
+  std::vector<std::unique_ptr<WorkQueue>> _queues;
+  std::function<void(int, Tile)> _task;
+  std::mutex _mutex;
+  std::condition_variable _start, _finish;
+  // incremented by every run, workers wait for the next value
+  uint64_t _generation = 0;
+  int _active = 0;
+  bool _stop = false;
+  std::atomic<uint64_t> _steals = 0;
+
+  bool _pop(int worker, Tile& tile);
+  void _work(int worker);
+
+ public:
+  // 0 threads means one per hardware thread
+  TileScheduler(int threads = 0);
+  // splits extent part of the image to tiles in row order
+  static std::vector<Tile> split(std::tuple<int, int> extent, int tileSize);
+  // blocks until task is called for every tile, task gets index of the worker, which can be used for per thread data
+  void run(std::vector<Tile> tiles, std::function<void(int worker, Tile tile)> task);
+  int getThreads();
+  // tiles taken from the other workers' queues by the last run
+  uint64_t getSteals();
+  ~TileScheduler();
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include "Kernels.h"
+#include <memory>
+
+// 8-wide BVH over scene spheres for SIMD kernels: every node tests its 8 child boxes at once and leaves hold
+// up to 8 spheres tested at once; the binary threaded BVH of the scene visits one box per step, so it's kept
+// only for scalar traversal which mirrors the GPU one
+class WideBVH {
+ private:
+  std::vector<WideNode> _nodes;
+  std::vector<SphereLeaf> _leaves;
+  // all spheres in scene order, groups of 8 for brute force traversal
+  std::vector<SphereLeaf> _sphereGroups;
+  // index of the root node or ~index of the root leaf
+  int _root;
+  // levels of inner nodes on the longest path from the root
+  int _depth = 0;
+
+  SphereLeaf _createLeaf(UniformSpheres& spheres, std::vector<int>& indices);
+  int _build(UniformSpheres& spheres, std::vector<int> indices, glm::vec3& min, glm::vec3& max, int level);
+
+ public:
+  // traversal stacks are fixed arrays of this size: every inner node on the path leaves at most 7 siblings,
+  // so the tree is checked against it when built
+  static constexpr int stackSize = 64;
+  WideBVH(std::shared_ptr<Scene> scene);
+  std::vector<WideNode>& getNodes();
+  std::vector<SphereLeaf>& getLeaves();
+  std::vector<SphereLeaf>& getSphereGroups();
+  int getRoot();
+};
@@ -112,4 +112,18 @@ class UniformBuffer {
                 std::shared_ptr<Queue> queue,
                 std::shared_ptr<Device> device);
   std::vector<std::shared_ptr<Buffer>>& getBuffer();
+};
+
+class StorageBuffer {
+ private:
+  std::shared_ptr<Buffer> _buffer;
+
+ public:
+  // device local buffer, if data is nullptr it's filled with zeros
+  StorageBuffer(VkDeviceSize size,
+                const void* data,
+                std::shared_ptr<CommandPool> commandPool,
+                std::shared_ptr<Queue> queue,
+                std::shared_ptr<Device> device);
+  std::shared_ptr<Buffer> getBuffer();
 };
\ No newline at end of file
@@ -8,7 +8,8 @@ class CommandPool {
   VkCommandPool _commandPool;
 
  public:
-  CommandPool(std::shared_ptr<Device> device);
+  // graphics family by default, command buffers of the pool can be submitted only to queues of its family
+  CommandPool(std::shared_ptr<Device> device, std::optional<uint32_t> queueFamilyIndex = std::nullopt);
   VkCommandPool& getCommandPool();
   ~CommandPool();
 };
@@ -12,6 +12,11 @@ class DescriptorSetLayout {
   DescriptorSetLayout(std::shared_ptr<Device> device);
   void createGraphic();
   void createCompute();
+  void createDenoise();
+  void createTemporal();
+  void createPostprocess();
+  void createReSTIR();
+  void createCache();
   void createGUI();
   VkDescriptorSetLayout& getDescriptorSetLayout();
   ~DescriptorSetLayout();
@@ -43,7 +48,45 @@ class DescriptorSet {
                      std::shared_ptr<UniformBuffer> uniformBuffer,
                      std::shared_ptr<UniformBuffer> uniformSpheres,
                      std::shared_ptr<UniformBuffer> uniformHitboxes,
-                     std::shared_ptr<UniformBuffer> uniformSettings);
+                     std::shared_ptr<StorageBuffer> storageSobol,
+                     std::vector<std::shared_ptr<Texture>> albedoOut,
+                     std::vector<std::shared_ptr<Texture>> normalDepthOut,
+                     std::shared_ptr<StorageBuffer> storageLights,
+                     std::shared_ptr<StorageBuffer> storageLightTree,
+                     std::shared_ptr<StorageBuffer> storageCache,
+                     std::shared_ptr<StorageBuffer> storageGuide);
+  // set i reads textureIn[i] with guides and writes textureOut[i]
+  void createDenoise(std::vector<std::shared_ptr<Texture>> textureIn,
+                     std::vector<std::shared_ptr<Texture>> albedo,
+                     std::vector<std::shared_ptr<Texture>> normalDepth,
+                     std::vector<std::shared_ptr<Texture>> textureOut);
+  // history of set i is the output of the previous frame
+  void createTemporal(std::shared_ptr<UniformBuffer> uniformBuffer,
+                      std::vector<std::shared_ptr<Texture>> textureIn,
+                      std::vector<std::shared_ptr<Texture>> normalDepth,
+                      std::vector<std::shared_ptr<Texture>> history,
+                      std::vector<std::shared_ptr<Texture>> historyNormalDepth,
+                      std::vector<std::shared_ptr<Texture>> textureOut);
+  // history reservoirs of set i are the final reservoirs of the previous frame
+  void createReSTIR(std::shared_ptr<UniformBuffer> uniformBuffer,
+                    std::shared_ptr<UniformBuffer> uniformSpheres,
+                    std::shared_ptr<UniformBuffer> uniformHitboxes,
+                    std::shared_ptr<StorageBuffer> storageLights,
+                    std::vector<std::shared_ptr<Texture>> albedo,
+                    std::vector<std::shared_ptr<Texture>> normalDepth,
+                    std::vector<std::shared_ptr<Texture>> historyNormalDepth,
+                    std::vector<std::shared_ptr<Texture>> textureOut,
+                    std::vector<std::shared_ptr<StorageBuffer>> initialReservoirs,
+                    std::vector<std::shared_ptr<StorageBuffer>> finalReservoirs,
+                    std::vector<std::shared_ptr<StorageBuffer>> historyReservoirs,
+                    std::vector<std::shared_ptr<Buffer>> statistics);
+  // the same cache in every set, statistics per frame
+  void createCache(std::shared_ptr<StorageBuffer> storageCache, std::vector<std::shared_ptr<Buffer>> statistics);
+  // the same histogram and exposure in every set
+  void createPostprocess(std::vector<std::shared_ptr<Texture>> textureIn,
+                     std::vector<std::shared_ptr<Texture>> textureOut,
+                     std::shared_ptr<StorageBuffer> histogram,
+                     std::shared_ptr<StorageBuffer> exposure);
   void createGUI(std::shared_ptr<Texture> texture, std::shared_ptr<UniformBuffer> uniformBuffer);
   std::vector<VkDescriptorSet>& getDescriptorSets();
 };
\ No newline at end of file
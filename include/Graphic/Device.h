@@ -20,11 +20,16 @@ class Device {
   std::shared_ptr<Instance> _instance;
   std::shared_ptr<Surface> _surface;
   VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
-  VkDevice _logicalDevice;
-  // device extension
-  const std::vector<const char*> _deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  VkDevice _logicalDevice = VK_NULL_HANDLE;
+  // device extension, swapchain one is required only with surface
+  std::vector<const char*> _deviceExtensions;
+  // name substring or index of device to use instead of the best ranked one, empty means the best one
+  std::string _preferred;
   // supported device features
   VkPhysicalDeviceFeatures _supportedFeatures;
+  VkPhysicalDeviceProperties _deviceProperties;
+  // zeroed if device is Vulkan 1.0
+  VkPhysicalDeviceSubgroupProperties _subgroupProperties{};
   // supported queues
   std::optional<uint32_t> _graphicsFamily;
   std::optional<uint32_t> _presentFamily;
@@ -37,11 +42,21 @@ class Device {
   void _createLogicalDevice();
   void _pickPhysicalDevice();
   bool _isDeviceSuitable(VkPhysicalDevice device);
+  // rank of suitable device: type first (discrete, integrated, virtual, CPU), then memory, queues and compute limits
+  float _scoreDevice(VkPhysicalDevice device);
+  // only picks physical device, used by listDevices
+  Device() = default;
 
  public:
-  Device(std::shared_ptr<Surface> surface, std::shared_ptr<Instance> instance);
+  // surface can be null, then presentation isn't required and any device with graphics and compute queues fits,
+  // including software ones like lavapipe or SwiftShader
+  Device(std::shared_ptr<Surface> surface, std::shared_ptr<Instance> instance, std::string preferred = "");
+  // prints devices with their scores and the one which would be picked, without creating logical device
+  static void listDevices(std::shared_ptr<Instance> instance, std::string preferred = "");
   VkDevice& getLogicalDevice();
   VkPhysicalDevice& getPhysicalDevice();
+  const VkPhysicalDeviceProperties& getDeviceProperties();
+  const VkPhysicalDeviceSubgroupProperties& getSubgroupProperties();
   std::vector<VkSurfaceFormatKHR>& getSupportedSurfaceFormats();
   std::vector<VkPresentModeKHR>& getSupportedSurfacePresentModes();
   VkSurfaceCapabilitiesKHR& getSupportedSurfaceCapabilities();
@@ -52,5 +67,6 @@ class Device {
   VkFormat findDepthBufferSupportedFormat(const std::vector<VkFormat>& candidates,
                                           VkImageTiling tiling,
                                           VkFormatFeatureFlags features);
+  bool isFormatFeatureSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features);
   ~Device();
 };
\ No newline at end of file
@@ -19,6 +19,7 @@ class Instance {
   bool _checkValidationLayersSupport();
 
  public:
+  // window can be null for surfaceless use
   Instance(std::string name, bool validation, std::shared_ptr<Window> window);
   const VkInstance& getInstance();
   const std::vector<const char*>& getValidationLayers();
@@ -4,23 +4,54 @@
 #include "Buffer.h"
 #include "Render.h"
 #include "Descriptor.h"
+#include <future>
+#include <map>
 
 class Pipeline {
  private:
   std::shared_ptr<Device> _device;
   std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
-  VkPipeline _pipeline;
-  VkPipelineLayout _pipelineLayout;
+  VkPipeline _pipeline = VK_NULL_HANDLE;
+  VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
   std::shared_ptr<Shader> _shader;
+  struct Variant {
+    VkPipeline pipeline;
+    // number of the selection which used the variant last, least recently used one is evicted first
+    uint64_t lastUse;
+  };
+  // compute pipeline variants, key is raw specialization constants data
+  std::map<std::vector<char>, Variant> _variants;
+  // variants compiled on worker threads, the current pipeline stays bound until they are ready
+  std::map<std::vector<char>, std::future<VkPipeline>> _pending;
+  // evicted variants with the selection they were evicted at, command buffers in flight may still use them
+  std::vector<std::tuple<VkPipeline, uint64_t>> _retired;
+  uint64_t _selections = 0;
+  int _maxVariants;
+
+  std::vector<char> _getKey(VkSpecializationInfo* specializationInfo);
+  void _createLayout(std::vector<VkPushConstantRange> pushConstants);
+  // copies specialization data, so it can run on worker thread after the caller's data is gone
+  std::future<VkPipeline> _compile(VkSpecializationInfo* specializationInfo, std::launch policy);
+  void _use(std::vector<char> key, VkPipeline pipeline);
+  void _evict();
 
  public:
+  // at most maxVariants compute variants are kept, least recently used ones are evicted
   Pipeline(std::shared_ptr<Shader> shader,
            std::shared_ptr<DescriptorSetLayout> descriptorSetLayout,
-           std::shared_ptr<Device> device);
+           std::shared_ptr<Device> device,
+           int maxVariants = 16);
   void createGraphic(VkVertexInputBindingDescription bindingDescription,
                      std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions,
                      std::shared_ptr<RenderPass> renderPass);
-  void createCompute();
+  // creates variant for specialization constants or reuses cached one, result becomes current pipeline
+  // push constant ranges are used only on first call, when layout is created
+  void createCompute(VkSpecializationInfo* specializationInfo = nullptr,
+                     std::vector<VkPushConstantRange> pushConstants = {});
+  // like createCompute, but missing variant is compiled on worker thread while the current pipeline stays, so
+  // changing settings doesn't stall frames; returns true if the requested variant is current.
+  // Parts select once per dispatch, evicted variants are destroyed a few selections later, after frames using them
+  bool selectCompute(VkSpecializationInfo* specializationInfo, std::vector<VkPushConstantRange> pushConstants = {});
   void createGUI(VkVertexInputBindingDescription bindingDescription,
                  std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions,
                  std::shared_ptr<RenderPass> renderPass);
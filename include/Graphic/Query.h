@@ -0,0 +1,28 @@
+#pragma once
+#include "Device.h"
+
+class QueryPool {
+ private:
+  std::shared_ptr<Device> _device;
+  VkQueryPool _queryPool;
+  int _number;
+  // timestamps of queues have only timestampValidBits bits, so they wrap around
+  uint64_t _validMask = ~0ull;
+  // frame slots whose queries were reset and written in a submitted frame
+  std::vector<bool> _frameWritten;
+
+ public:
+  // pool of timestamp queries
+  QueryPool(int number, std::shared_ptr<Device> device);
+  // results in device ticks, empty if some of the queries aren't available yet
+  std::optional<std::vector<uint64_t>> getResults(int first, int count, bool wait);
+  // converts difference between two timestamps to milliseconds, end can be past wrap around of the counter
+  float getElapsed(uint64_t begin, uint64_t end);
+  // per frame use, every frame in flight owns count queries starting at currentFrame * count:
+  // records reset of the slot's queries, timestamps of the frame are written after it
+  void resetFrame(VkCommandBuffer commandBuffer, int currentFrame, int count);
+  // milliseconds between consecutive timestamps of the previous frame which used the slot, empty if there wasn't one
+  std::optional<std::vector<float>> getFrameTimes(int currentFrame, int count);
+  VkQueryPool& getQueryPool();
+  ~QueryPool();
+};
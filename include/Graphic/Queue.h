@@ -3,10 +3,18 @@
 
 class Queue {
  private:
-  VkQueue _graphicQueue, _presentQueue;
+  VkQueue _graphicQueue, _presentQueue, _computeQueue;
+  uint32_t _graphicFamily, _computeFamily;
 
  public:
-  Queue(std::shared_ptr<Device> device);
+  // compute queue is taken from family without graphics if device has one, otherwise it's the graphic queue;
+  // asyncCompute = false forces the graphic queue, e.g. to compare both
+  Queue(std::shared_ptr<Device> device, bool asyncCompute = true);
   VkQueue& getGraphicQueue();
   VkQueue& getPresentQueue();
+  VkQueue& getComputeQueue();
+  uint32_t getGraphicFamilyIndex();
+  uint32_t getComputeFamilyIndex();
+  // compute and graphic queues are from different families, resources need ownership transfer between them
+  bool isAsyncCompute();
 };
\ No newline at end of file
@@ -11,6 +11,8 @@ class RenderPass {
   RenderPass(VkFormat format, std::shared_ptr<Device> device);
   void initialize();
   void initializeOffscreen();
+  // keeps content blitted to swapchain image before the pass, so only overlay is drawn on top
+  void initializeOverlay();
   VkRenderPass& getRenderPass();
   ~RenderPass();
 };
@@ -12,6 +12,7 @@ class Swapchain {
   std::shared_ptr<ImageView> _depthImageView;
   VkFormat _swapchainImageFormat;
   VkExtent2D _swapchainExtent;
+  VkImageUsageFlags _imageUsage;
 
  public:
   Swapchain(std::shared_ptr<Window> window, std::shared_ptr<Surface> surface, std::shared_ptr<Device> device);
@@ -20,5 +21,6 @@ class Swapchain {
   std::vector<std::shared_ptr<ImageView>>& getImageViews();
   std::shared_ptr<ImageView> getDepthImageView();
   VkFormat& getImageFormat();
+  VkImageUsageFlags getImageUsage();
   ~Swapchain();
 };
\ No newline at end of file
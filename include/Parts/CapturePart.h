@@ -0,0 +1,66 @@
+#pragma once
+#include "Device.h"
+#include "Settings.h"
+#include "Sync.h"
+#include "Buffer.h"
+#include "Texture.h"
+#include "ImageEncoder.h"
+#include <future>
+#include <map>
+
+// copies finished frames to a ring of host visible buffers in own submits with fence per slot, finished copies are
+// encoded to files on worker threads; drawFrame never waits for either, if every slot is busy the frame is dropped
+class CapturePart {
+ private:
+  enum class SlotState { FREE, COPYING, ENCODING };
+
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<Queue> _queue;
+  std::shared_ptr<Settings> _settings;
+  // one command buffer, staging buffer and fence per slot of the ring
+  std::shared_ptr<CommandBuffer> _commandBuffer;
+  std::vector<std::shared_ptr<Buffer>> _stagingBuffers;
+  std::vector<std::shared_ptr<Fence>> _fences;
+  std::vector<std::future<void>> _jobs;
+  // encoders and pixel buffers are kept, so capturing a sequence doesn't allocate per frame
+  std::vector<std::shared_ptr<ImageEncoder>> _encoders;
+  std::vector<std::vector<glm::vec4>> _pixels;
+  std::vector<SlotState> _states;
+  // part of the image copied to the slot and number of the captured frame in the file name
+  std::vector<std::tuple<int, int>> _extents;
+  std::vector<int> _numbers;
+  int _next = 0;
+
+  std::map<std::string, bool*> _checkboxes;
+  bool _enabled = false;
+  // captured frames are numbered: path "capture.png" gives capture_00000.png, capture_00001.png...
+  std::string _path = "capture.png";
+  // the captured image is gamma encoded by PostprocessPart, encoders expect linear values
+  bool _decodeGamma = false;
+  int _captured = 0;
+  int _dropped = 0;
+
+  void _collect();
+  void _encode(int slot);
+
+ public:
+  // ring of 4 slots keeps one frame encoding per core on most machines while frames keep flowing
+  CapturePart(std::shared_ptr<Device> device,
+              std::shared_ptr<Queue> queue,
+              std::shared_ptr<CommandPool> commandPool,
+              std::shared_ptr<Settings> settings,
+              int slots = 4);
+  void setPath(std::string path);
+  void setEnabled(bool enabled);
+  void setDecodeGamma(bool decodeGamma);
+  // submits copy of extent part of the texture after the frame which wrote it, must be called after frame's submit;
+  // finished is signaled when the copy is done, false is returned if nothing is submitted (disabled or dropped)
+  bool capture(std::shared_ptr<Texture> texture, std::tuple<int, int> extent, VkSemaphore finished);
+  // waits for all copies and encoders, e.g. before exit
+  void flush();
+  std::map<std::string, bool*> getCheckboxes();
+  int getCaptured();
+  // frames skipped because all slots were still copying or encoding
+  int getDropped();
+  ~CapturePart();
+};
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "Shader.h"
 #include "Descriptor.h"
 #include "Pipeline.h"
+#include "Query.h"
+#include "Scene.h"
 
 class ComputePart {
  private:
@@ -13,6 +15,7 @@ class ComputePart {
   std::shared_ptr<Queue> _queue;
   std::shared_ptr<CommandPool> _commandPool;
   std::shared_ptr<Settings> _settings;
+  std::shared_ptr<Scene> _scene;
 
   std::shared_ptr<RenderPass> _renderPass;
   std::shared_ptr<Framebuffer> _framebuffer;
@@ -21,23 +24,140 @@ class ComputePart {
   std::shared_ptr<DescriptorSet> _descriptorSet;
   std::shared_ptr<CommandBuffer> _commandBuffer;
   std::shared_ptr<DescriptorPool> _descriptorPool;
-  std::shared_ptr<UniformBuffer> _uniformBuffer, _uniformBufferSpheres, _uniformBufferHitboxes, _uniformBufferSettings;
+  std::shared_ptr<UniformBuffer> _uniformBuffer, _uniformBufferSpheres, _uniformBufferHitboxes;
+  std::shared_ptr<StorageBuffer> _storageBufferSobol, _storageBufferLights, _storageBufferLightTree;
+  // hashed grid of radiance leaving diffuse surfaces, filled by paths and maintained by separate pass
+  std::shared_ptr<StorageBuffer> _storageBufferCache;
+  std::shared_ptr<Shader> _cacheShader;
+  std::shared_ptr<Pipeline> _cachePipeline;
+  std::shared_ptr<DescriptorSetLayout> _cacheDescriptorSetLayout;
+  std::shared_ptr<DescriptorSet> _cacheDescriptorSet;
+  // host visible counters written by maintenance pass, read back when frame slot is reused
+  std::vector<std::shared_ptr<Buffer>> _cacheStatistics;
+  // hashed grid of directional histograms of incident light, uses the cache descriptor layout
+  std::shared_ptr<StorageBuffer> _storageBufferGuide;
+  std::shared_ptr<Shader> _guideShader;
+  std::shared_ptr<Pipeline> _guidePipeline;
+  std::shared_ptr<DescriptorSet> _guideDescriptorSet;
+  std::vector<std::shared_ptr<Buffer>> _guideStatistics;
   std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
 
   std::vector<std::shared_ptr<Texture>> _resultTextures;
+  std::vector<std::shared_ptr<Texture>> _albedoTextures, _normalDepthTextures;
   std::map<std::string, bool*> _checkboxes;
+  std::map<std::string, std::tuple<int*, int, int>> _sliders;
+  std::map<std::string, std::tuple<float*, float, float>> _slidersFloat;
+
+  // values are baked into pipeline as specialization constants
+  int _aaSamples = 4;
+  int _maxDepth = 50;
+  bool _useBVH = false;
+  bool _useNEE = true;
+  bool _useLightBVH = true;
+  // direct light at primary diffuse hits is left to ReSTIRPart
+  bool _useReSTIR = false;
+  bool _useCache = false;
+  // cells are colored by occupancy instead of ray traced color
+  bool _cacheDebug = false;
+  bool _useGuiding = false;
+  std::array<int, 2> _workgroupSize = {16, 16};
+  UniformCamera _camera{};
+  // shifts sample indices, so every frame gets new samples for temporal accumulation
+  uint32_t _frameIndex = 0;
+
+  // dynamic resolution, images keep full size and only extent part of them is rendered
+  std::shared_ptr<QueryPool> _queryPool;
+  bool _dynamicResolution = false;
+  float _targetTime = 16.f;
+  float _time = 0.f;
+  float _scale = 1.f;
+  std::tuple<int, int> _extent;
+  // hybrid mode: part of the extent rows rendered by the dispatch, the rest comes from CPU tracer
+  float _gpuShare = 1.f;
+  int _rows;
+
+  // cell size at distance 1 from camera, doubles with every octave of distance
+  float _cacheCellSize = 0.1f;
+  // cell is used to end paths only after it has so many samples
+  int _cacheMinSamples = 16;
+  int _cacheMaxSamples = 256;
+  // frames without updates before cell is evicted
+  int _cacheMaxAge = 30;
+  float _cacheOccupancy = 0.f;
+  // host visible counters of a hashed grid for every frame in flight, zeroed
+  std::vector<std::shared_ptr<Buffer>> _createHashGridStatistics(int size);
+  // maintenance pass of a hashed grid filled by ray tracing: one invocation per cell with parameters as push
+  // constants, statistics are cleared before it and readable on host after the frame's fence
+  void _updateHashGrid(VkCommandBuffer commandBuffer,
+                       std::shared_ptr<Pipeline> pipeline,
+                       VkDescriptorSet descriptorSet,
+                       std::shared_ptr<Buffer> statistics,
+                       int capacity,
+                       const void* parameters,
+                       uint32_t parametersSize);
+
+  // guiding cells are positional only, so they are coarser than radiance cache ones
+  float _guideCellSize = 0.5f;
+  // the rest of diffuse bounces sample cosine lobe, so directions missed by the guide keep nonzero pdf
+  float _guideFraction = 0.5f;
+  int _guideMinSamples = 64;
+  int _guideMaxAge = 120;
+  float _guideDecay = 0.95f;
+  float _guideOccupancy = 0.f;
+  void _updateScale();
+  // async keeps the current variant bound until the new one is compiled, used per frame so settings don't stall
+  void _selectVariant(bool async = false);
+  void _updateCamera(int currentFrame);
+  void _dispatch(VkCommandBuffer commandBuffer, int currentFrame);
 
  public:
-  ComputePart(std::shared_ptr<Device> device,
+  ComputePart(std::shared_ptr<Scene> scene,
+              std::shared_ptr<Device> device,
               std::shared_ptr<Queue> queue,
               std::shared_ptr<CommandBuffer> commandBuffer,
               std::shared_ptr<CommandPool> commandPool,
               std::shared_ptr<Settings> settings);
+  // loads workgroup shape tuned for current device from file, if force is set benchmarks shapes and saves the best
+  void autotune(std::string path, bool force);
   void draw(int currentFrame);
+  // camera used by last draw
+  UniformCamera getCamera();
 
   std::map<std::string, bool*> getCheckboxes();
+  std::map<std::string, std::tuple<int*, int, int>> getSliders();
+  std::map<std::string, std::tuple<float*, float, float>> getSlidersFloat();
+  // part of result textures rendered by last draw
+  std::tuple<int, int> getExtent();
+  // share of rows for the next draw, rounded to whole bands
+  void setGPUShare(float share);
+  // rows of the extent rendered by last draw, counted from the bottom like invocation y of the shader
+  int getRows();
+  // samples per pixel of every frame, the same range as the slider
+  void setAASamples(int aaSamples);
+  // settings which CPU tracer mirrors in hybrid mode
+  int getAASamples();
+  int getMaxDepth();
+  bool isBVH();
+  bool isNEE();
+  bool isLightBVH();
+  // frame index used by last draw
+  uint32_t getFrameIndex();
+  // GPU time of ray tracing without radiance cache and guiding maintenance in milliseconds, measured when this frame
+  // slot was used last time
+  float getTime();
+  float getScale();
+  // part of radiance cache cells which are in use
+  float getCacheOccupancy();
+  // part of path guiding cells which are in use
+  float getGuideOccupancy();
+  void setReSTIR(bool useReSTIR);
 
   std::vector<std::shared_ptr<Texture>> getResultTextures();
+  std::vector<std::shared_ptr<Texture>> getAlbedoTextures();
+  std::vector<std::shared_ptr<Texture>> getNormalDepthTextures();
+  std::shared_ptr<UniformBuffer> getUniformBufferSpheres();
+  std::shared_ptr<UniformBuffer> getUniformBufferHitboxes();
+  std::shared_ptr<StorageBuffer> getStorageBufferLights();
   std::shared_ptr<Pipeline> getPipeline();
   std::shared_ptr<DescriptorSet> getDescriptorSet();
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "Device.h"
+#include "Texture.h"
+#include "Settings.h"
+#include "Shader.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "Query.h"
+
+// edge-avoiding a-trous filter guided by albedo, normal and depth from ComputePart
+class DenoisePart {
+ private:
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<Queue> _queue;
+  std::shared_ptr<CommandPool> _commandPool;
+  std::shared_ptr<CommandBuffer> _commandBuffer;
+  std::shared_ptr<Settings> _settings;
+
+  std::shared_ptr<Pipeline> _pipeline;
+  std::shared_ptr<Shader> _shader;
+  std::shared_ptr<DescriptorSet> _descriptorSet;
+  std::shared_ptr<DescriptorPool> _descriptorPool;
+  std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
+  std::shared_ptr<QueryPool> _queryPool;
+
+  std::vector<std::shared_ptr<Texture>> _inputTextures;
+  // two intermediate textures per frame, iterations alternate between them
+  std::vector<std::array<std::shared_ptr<Texture>, 2>> _pingPongTextures;
+  std::vector<std::shared_ptr<Texture>> _resultTextures;
+  // descriptor set per frame for every (source, destination) pair that can appear in the chain
+  std::vector<std::tuple<int, int>> _pairs;
+  float _time = 0.f;
+
+  std::map<std::string, bool*> _checkboxes;
+  std::map<std::string, std::tuple<int*, int, int>> _sliders;
+  std::map<std::string, std::tuple<float*, float, float>> _slidersFloat;
+  bool _enabled = true;
+  int _iterations = 5;
+  float _sigmaColor = 0.6f;
+  float _sigmaNormal = 64.f;
+  float _sigmaDepth = 0.1f;
+  float _sigmaAlbedo = 0.1f;
+
+  int _getSetIndex(int currentFrame, int source, int destination);
+
+ public:
+  DenoisePart(std::vector<std::shared_ptr<Texture>> inputTextures,
+              std::vector<std::shared_ptr<Texture>> albedoTextures,
+              std::vector<std::shared_ptr<Texture>> normalDepthTextures,
+              std::shared_ptr<Device> device,
+              std::shared_ptr<Queue> queue,
+              std::shared_ptr<CommandBuffer> commandBuffer,
+              std::shared_ptr<CommandPool> commandPool,
+              std::shared_ptr<Settings> settings);
+  // only extent part of the images is filtered
+  void draw(int currentFrame, std::tuple<int, int> extent);
+  // GPU time of the filter in milliseconds, measured when this frame slot was used last time
+  float getTime();
+
+  std::map<std::string, bool*> getCheckboxes();
+  std::map<std::string, std::tuple<int*, int, int>> getSliders();
+  std::map<std::string, std::tuple<float*, float, float>> getSlidersFloat();
+  std::vector<std::shared_ptr<Texture>> getResultTextures();
+};
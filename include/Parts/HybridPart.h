@@ -0,0 +1,58 @@
+#pragma once
+#include "Device.h"
+#include "Settings.h"
+#include "Buffer.h"
+#include "ComputePart.h"
+#include "PathTracer.h"
+#include <future>
+#include <atomic>
+
+// splits ray tracing of a frame between the dispatch of ComputePart and CPU tracer: GPU takes the bottom bands,
+// CPU traces the rest on a worker thread while GPU runs the already submitted dispatch, then host records copy of
+// CPU rows to the images of ComputePart into the next submit, so GPU never waits for host; the split follows measured
+// time per row of both sides
+class HybridPart {
+ private:
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<CommandBuffer> _commandBuffer;
+  std::shared_ptr<Settings> _settings;
+  std::shared_ptr<TileScheduler> _scheduler;
+  std::shared_ptr<PathTracer> _pathTracer;
+
+  // host visible copies of CPU rows of result, albedo and normal-depth images, in their texel formats
+  std::vector<std::shared_ptr<Buffer>> _stagingBuffers;
+  // tracer is shared by all frame slots, so CPU part of the frame starts only after the previous one is done
+  std::future<void> _job;
+  // rows traced by GPU when the frame slot was used last time, its GPU time is measured for them
+  std::vector<int> _gpuRows;
+  // written by the CPU part of the frame when it's done
+  std::atomic<int> _cpuRows = 0;
+  std::atomic<float> _cpuTime = 0.f;
+
+  std::map<std::string, bool*> _checkboxes;
+  bool _enabled = false;
+  // every time hybrid mode is enabled it starts from even split
+  float _gpuShare = 0.5f;
+
+  void _updateShare(int currentFrame, float gpuTime);
+  // offsets of albedo and normal-depth rows in the staging buffer, copies need them to be multiples of texel size
+  std::tuple<VkDeviceSize, VkDeviceSize> _getOffsets(VkDeviceSize pixels);
+  void _trace(int currentFrame, UniformCamera camera, std::tuple<int, int> extent, uint32_t frameIndex, int rows);
+
+ public:
+  HybridPart(std::shared_ptr<Scene> scene,
+             std::shared_ptr<Device> device,
+             std::shared_ptr<CommandBuffer> commandBuffer,
+             std::shared_ptr<Settings> settings);
+  // share of rows for the next ComputePart draw, 1 if hybrid mode is disabled
+  float getGPUShare();
+  // starts CPU part of the frame just drawn by compute part, its dispatch has to be submitted before merge
+  void draw(int currentFrame, std::shared_ptr<ComputePart> computePart);
+  // waits on host for CPU part and records copy of its rows, command buffer is submitted after the dispatch one
+  void merge(int currentFrame, std::shared_ptr<ComputePart> computePart);
+  std::map<std::string, bool*> getCheckboxes();
+  // CPU time of the last finished CPU part in milliseconds
+  float getCPUTime();
+  int getThreads();
+  ~HybridPart();
+};
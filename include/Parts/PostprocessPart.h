@@ -0,0 +1,80 @@
+#pragma once
+#include "Device.h"
+#include "Texture.h"
+#include "Settings.h"
+#include "Shader.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "Query.h"
+#include <chrono>
+
+// per pixel post effects from HDR radiance to the range displayed by ScreenPart, fused into one dispatch;
+// auto exposure is measured from luminance histogram and never leaves GPU
+class PostprocessPart {
+ private:
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<Queue> _queue;
+  std::shared_ptr<CommandPool> _commandPool;
+  std::shared_ptr<CommandBuffer> _commandBuffer;
+  std::shared_ptr<Settings> _settings;
+
+  std::shared_ptr<Pipeline> _pipeline;
+  std::shared_ptr<Shader> _shader;
+  std::shared_ptr<DescriptorSet> _descriptorSet;
+  std::shared_ptr<DescriptorPool> _descriptorPool;
+  std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
+  std::shared_ptr<QueryPool> _queryPool;
+  std::shared_ptr<Shader> _histogramShader, _exposureShader;
+  std::shared_ptr<Pipeline> _histogramPipeline, _exposurePipeline;
+  std::shared_ptr<StorageBuffer> _storageBufferHistogram, _storageBufferExposure;
+  std::chrono::steady_clock::time_point _lastTime;
+
+  std::vector<std::shared_ptr<Texture>> _resultTextures;
+  // milliseconds of histogram, exposure and effects passes, timestamps are written between them
+  std::map<std::string, float> _times;
+  bool _encodeGamma = false;
+
+  std::map<std::string, bool*> _checkboxes;
+  std::map<std::string, std::tuple<int*, int, int>> _sliders;
+  std::map<std::string, std::tuple<float*, float, float>> _slidersFloat;
+  // exposure value in stops, 0 keeps radiance as is; compensation if auto exposure is on
+  float _exposure = 0.f;
+  bool _autoExposure = true;
+  // histogram covers log2 luminance from min to min + range
+  float _minLogLuminance = -10.f;
+  float _logLuminanceRange = 16.f;
+  // 1 / seconds
+  float _adaptationSpeed = 1.5f;
+  // values are baked into pipeline as specialization constants, 0 - clamp, 1 - Reinhard, 2 - ACES
+  int _tonemapper = 2;
+  bool _sharpen = false;
+  bool _colorGrading = false;
+  bool _grayscale = false;
+  bool _vignette = false;
+  float _sharpness = 0.5f;
+  float _saturation = 1.f;
+  float _contrast = 1.f;
+  float _temperature = 0.f;
+  float _vignetteStrength = 0.5f;
+  // async keeps the current variant bound until the new one is compiled, used per frame so settings don't stall
+  void _selectVariant(bool async = false);
+
+ public:
+  PostprocessPart(std::vector<std::shared_ptr<Texture>> inputTextures,
+                  std::shared_ptr<Device> device,
+                  std::shared_ptr<Queue> queue,
+                  std::shared_ptr<CommandBuffer> commandBuffer,
+                  std::shared_ptr<CommandPool> commandPool,
+                  std::shared_ptr<Settings> settings);
+  // only extent part of the images is processed
+  void draw(int currentFrame, std::tuple<int, int> extent);
+  // shader encodes sRGB itself if display format doesn't do it on write
+  void setEncodeGamma(bool encodeGamma);
+  // GPU time of every pass in milliseconds, measured when this frame slot was used last time
+  std::map<std::string, float> getTimes();
+
+  std::map<std::string, bool*> getCheckboxes();
+  std::map<std::string, std::tuple<int*, int, int>> getSliders();
+  std::map<std::string, std::tuple<float*, float, float>> getSlidersFloat();
+  std::vector<std::shared_ptr<Texture>> getResultTextures();
+};
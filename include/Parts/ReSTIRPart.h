@@ -0,0 +1,71 @@
+#pragma once
+#include "Device.h"
+#include "Texture.h"
+#include "Settings.h"
+#include "Shader.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "Query.h"
+#include "ComputePart.h"
+
+// spatiotemporal reservoir resampling of direct light at primary hits, adds the result to ray traced image
+class ReSTIRPart {
+ private:
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<Queue> _queue;
+  std::shared_ptr<CommandPool> _commandPool;
+  std::shared_ptr<CommandBuffer> _commandBuffer;
+  std::shared_ptr<Settings> _settings;
+
+  std::shared_ptr<Pipeline> _pipeline;
+  std::shared_ptr<Shader> _shader;
+  std::shared_ptr<DescriptorSet> _descriptorSet;
+  std::shared_ptr<DescriptorPool> _descriptorPool;
+  std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
+  std::shared_ptr<UniformBuffer> _uniformBuffer;
+  std::shared_ptr<QueryPool> _queryPool;
+
+  // reservoirs after temporal reuse and after spatial reuse, the latter are history of the next frame
+  std::vector<std::shared_ptr<StorageBuffer>> _initialReservoirs, _finalReservoirs;
+  // host visible counters written by shader, read back when frame slot is reused
+  std::vector<std::shared_ptr<Buffer>> _statistics;
+  UniformCamera _previousCamera{};
+  std::tuple<int, int> _previousExtent;
+  bool _reset = true;
+  uint32_t _frame = 0;
+  float _time = 0.f;
+  float _candidates = 0.f;
+  float _visible = 0.f;
+
+  std::map<std::string, bool*> _checkboxes;
+  std::map<std::string, std::tuple<int*, int, int>> _sliders;
+  std::map<std::string, std::tuple<float*, float, float>> _slidersFloat;
+  bool _enabled = false;
+  int _initialCandidates = 8;
+  int _spatialSamples = 4;
+  float _spatialRadius = 16.f;
+  int _maxHistory = 20;
+  float _depthThreshold = 0.05f;
+  float _normalThreshold = 0.9f;
+
+ public:
+  ReSTIRPart(std::shared_ptr<ComputePart> computePart,
+             std::shared_ptr<Device> device,
+             std::shared_ptr<Queue> queue,
+             std::shared_ptr<CommandBuffer> commandBuffer,
+             std::shared_ptr<CommandPool> commandPool,
+             std::shared_ptr<Settings> settings);
+  // camera and extent are the ones used to render current frame, does nothing if disabled
+  void draw(int currentFrame, UniformCamera camera, std::tuple<int, int> extent);
+  bool isEnabled();
+  // GPU time of both passes in milliseconds, measured when this frame slot was used last time
+  float getTime();
+  // average number of candidates in the final reservoir of shaded pixel
+  float getCandidates();
+  // part of shaded pixels where the selected light sample is visible
+  float getVisible();
+
+  std::map<std::string, bool*> getCheckboxes();
+  std::map<std::string, std::tuple<int*, int, int>> getSliders();
+  std::map<std::string, std::tuple<float*, float, float>> getSlidersFloat();
+};
@@ -15,10 +15,15 @@ class ScreenPart {
   std::shared_ptr<Settings> _settings;
 
   std::shared_ptr<Swapchain> _swapchain;
-  std::shared_ptr<RenderPass> _renderPass;
+  std::shared_ptr<RenderPass> _renderPass, _renderPassOverlay;
   std::shared_ptr<Framebuffer> _frameBuffer;
-  std::shared_ptr<SpriteManager> _spriteManager;
-  std::vector<std::shared_ptr<Sprite>> _sprites;
+  std::shared_ptr<SpriteManager> _spriteManager, _spriteManagerUpscale;
+  std::vector<std::shared_ptr<Sprite>> _sprites, _spritesUpscale;
+  std::vector<std::shared_ptr<Texture>> _resultTextures;
+  std::map<std::string, bool*> _checkboxes;
+  bool _edgeAware = false;
+  // result is blitted straight to swapchain image, sprite draw and its descriptors are skipped
+  bool _directPresent = false;
 
  public:
   ScreenPart(std::vector<std::shared_ptr<Texture>> resultTexture,
@@ -29,9 +34,17 @@ class ScreenPart {
              std::shared_ptr<CommandPool> commandPool,
              std::shared_ptr<CommandBuffer> commandBuffer,
              std::shared_ptr<Settings> settings);
+  // only extent part of result texture is stretched to the screen
+  void setExtent(std::tuple<int, int> extent);
+  // records blit of extent part of the result to swapchain image, has to be followed by overlay render pass
+  void blit(int currentFrame, int imageIndex, std::tuple<int, int> extent);
+  bool isDirectPresent();
+  std::map<std::string, bool*> getCheckboxes();
   std::shared_ptr<Framebuffer> getFramebuffer();
+  // render pass of the selected present path, both are compatible with pipelines created for any of them
   std::shared_ptr<RenderPass> getRenderPass();
   std::shared_ptr<Swapchain> getSwapchain();
+  // sprites and manager of the selected upscale filter
   std::vector<std::shared_ptr<Sprite>> getSprites();
   std::shared_ptr<SpriteManager> getSpriteManager();
 };
\ No newline at end of file
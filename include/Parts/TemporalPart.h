@@ -0,0 +1,55 @@
+#pragma once
+#include "Device.h"
+#include "Texture.h"
+#include "Settings.h"
+#include "Shader.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "ComputePart.h"
+
+// accumulates ray traced frames over time, previous result is reprojected using camera motion
+class TemporalPart {
+ private:
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<Queue> _queue;
+  std::shared_ptr<CommandPool> _commandPool;
+  std::shared_ptr<CommandBuffer> _commandBuffer;
+  std::shared_ptr<Settings> _settings;
+
+  std::shared_ptr<Pipeline> _pipeline;
+  std::shared_ptr<Shader> _shader;
+  std::shared_ptr<DescriptorSet> _descriptorSet;
+  std::shared_ptr<DescriptorPool> _descriptorPool;
+  std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
+  std::shared_ptr<UniformBuffer> _uniformBuffer;
+
+  // alpha channel stores number of accumulated frames
+  std::vector<std::shared_ptr<Texture>> _resultTextures;
+  UniformCamera _previousCamera{};
+  std::tuple<int, int> _previousExtent;
+  bool _reset = true;
+
+  std::map<std::string, bool*> _checkboxes;
+  std::map<std::string, std::tuple<int*, int, int>> _sliders;
+  std::map<std::string, std::tuple<float*, float, float>> _slidersFloat;
+  bool _enabled = true;
+  int _maxHistory = 16;
+  float _depthThreshold = 0.05f;
+  float _normalThreshold = 0.9f;
+
+ public:
+  TemporalPart(std::vector<std::shared_ptr<Texture>> inputTextures,
+               std::vector<std::shared_ptr<Texture>> normalDepthTextures,
+               std::shared_ptr<Device> device,
+               std::shared_ptr<Queue> queue,
+               std::shared_ptr<CommandBuffer> commandBuffer,
+               std::shared_ptr<CommandPool> commandPool,
+               std::shared_ptr<Settings> settings);
+  // camera and extent are the ones used to render current frame
+  void draw(int currentFrame, UniformCamera camera, std::tuple<int, int> extent);
+
+  std::map<std::string, bool*> getCheckboxes();
+  std::map<std::string, std::tuple<int*, int, int>> getSliders();
+  std::map<std::string, std::tuple<float*, float, float>> getSlidersFloat();
+  std::vector<std::shared_ptr<Texture>> getResultTextures();
+};
@@ -0,0 +1,101 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+// structures below match std140/std430 layouts of raytracing.comp, the same data is traced by GPU and CPU backends
+enum MaterialType { MATERIAL_DIFFUSE = 0, MATERIAL_METAL = 1, MATERIAL_DIELECTRIC = 2, MATERIAL_EMISSIVE = 3 };
+
+struct UniformCamera {
+  float fov;
+  alignas(16) glm::vec3 origin;
+  alignas(16) glm::mat4 camera;
+};
+
+struct UniformMaterial {
+  int type;
+  alignas(16) glm::vec3 attenuation;
+  // actual only for metal
+  float fuzz;
+  // actual only for dielectric (etaIn / etaOut)
+  float refraction;
+};
+
+struct UniformSphere {
+  alignas(16) glm::vec3 center;
+  float radius;
+  int index;
+  // leaf of the light tree for emissive spheres, -1 otherwise
+  int lightNode;
+  UniformMaterial material;
+};
+
+struct UniformSpheres {
+  int number;
+  UniformSphere spheres[300];
+};
+
+struct HitBoxTemp {
+  glm::vec3 center;
+  glm::vec3 bias;
+  int index;
+  int left;
+  int right;
+  int parent;
+  int sphere;
+};
+
+struct HitBox {
+  alignas(16) glm::vec3 min;
+  alignas(16) glm::vec3 max;
+  int next;
+  int exit;
+  int sphere;
+};
+
+struct UniformHitBox {
+  int number;
+  HitBox hitbox[300];
+};
+
+// node of the light tree, matches std430 layout of LightNode in raytracing.comp
+struct LightNode {
+  alignas(16) glm::vec3 min;
+  // emitted flux of all lights under the node
+  float power;
+  glm::vec3 max;
+  int left;
+  int right;
+  int parent;
+  // sphere index for leaves, -1 for internal nodes
+  int light;
+};
+
+// camera looking from origin along direction, fov is vertical in degrees
+UniformCamera createCamera(glm::vec3 origin, glm::vec3 direction, glm::vec3 up, float fov);
+
+// spheres, threaded BVH over them and light tree over emissive ones; generated once from seed, so both
+// backends and separate runs with the same seed see the same scene
+class Scene {
+ private:
+  std::mt19937 _engine;
+  UniformSpheres _spheres;
+  UniformHitBox _hitboxes;
+  // number of lights followed by indices of emissive spheres
+  std::vector<int> _lights;
+  std::vector<LightNode> _lightTree;
+
+  int _calculateHitbox(std::vector<UniformSphere> spheres, std::vector<HitBoxTemp>& hitBox, int parent);
+
+ public:
+  Scene(uint32_t seed);
+  UniformSpheres& getSpheres();
+  UniformHitBox& getHitboxes();
+  std::vector<int>& getLights();
+  // never empty, tree of the scene without lights has one unused node
+  std::vector<LightNode>& getLightTree();
+};
@@ -17,6 +17,13 @@ class Texture {
           std::shared_ptr<Queue> queue,
           std::shared_ptr<Device> device);
   Texture(std::shared_ptr<ImageView> imageView, std::shared_ptr<Device> device);
+  // empty device local texture in general layout, render target of compute parts
+  Texture(std::tuple<int, int> resolution,
+          VkFormat format,
+          VkImageUsageFlags usage,
+          std::shared_ptr<CommandPool> commandPool,
+          std::shared_ptr<Queue> queue,
+          std::shared_ptr<Device> device);
   std::shared_ptr<ImageView> getImageView();
   std::shared_ptr<Sampler> getSampler();
 };
\ No newline at end of file
@@ -82,6 +82,15 @@ class GUI {
                    std::tuple<int, int> position,
                    std::tuple<int, int> size,
                    std::map<std::string, bool*> variable);
+  // variable is tuple of value, min and max
+  void addSlider(std::string name,
+                 std::tuple<int, int> position,
+                 std::tuple<int, int> size,
+                 std::map<std::string, std::tuple<int*, int, int>> variable);
+  void addSlider(std::string name,
+                 std::tuple<int, int> position,
+                 std::tuple<int, int> size,
+                 std::map<std::string, std::tuple<float*, float, float>> variable);
   void updateBuffers(int current);
   void drawFrame(int current, VkCommandBuffer commandBuffer);
   ~GUI();
@@ -0,0 +1,49 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include "TileScheduler.h"
+#include <vector>
+#include <string>
+#include <tuple>
+
+// PNG and EXR writer compressing bands of rows in parallel: PNG bands are deflated independently, flushed to byte
+// boundary and joined into one zlib stream, EXR uses ZIP compression whose 16 scanline blocks are independent anyway;
+// bands don't depend on thread count, so files are the same for any number of threads. Buffers are kept between
+// calls, so encoding a sequence of frames of the same size doesn't allocate
+class ImageEncoder {
+ private:
+  // per worker buffers of filtering and compression
+  struct Scratch {
+    std::vector<uint8_t> bytes, reordered;
+    std::vector<uint8_t> row, previousRow, candidates;
+    std::vector<int32_t> head, chain;
+    std::vector<uint32_t> tokens;
+  };
+  // compressed band, crc is computed by worker too, except for the last PNG band which gets adler appended
+  struct Chunk {
+    std::vector<uint8_t> data;
+    uint32_t adler;
+    uint32_t crc;
+  };
+  std::shared_ptr<TileScheduler> _scheduler;
+  std::vector<Scratch> _scratch;
+  std::vector<Chunk> _chunks;
+  std::vector<uint8_t> _header;
+
+  void _run(std::vector<Tile> tiles, std::function<void(int worker, Tile tile)> task);
+  void _encodePNGBand(Scratch& scratch, Chunk& chunk, Tile tile, bool first, bool last,
+                      const std::vector<glm::vec4>& pixels);
+  void _encodeEXRBlock(Scratch& scratch, Chunk& chunk, Tile tile, const std::vector<glm::vec4>& pixels);
+
+ public:
+  // without scheduler bands are compressed one by one on the calling thread, e.g. if frames are encoded in parallel
+  ImageEncoder(std::shared_ptr<TileScheduler> scheduler = nullptr);
+  // pixels are linear radiance, rows are stored top to bottom like in result textures;
+  // 8 bit sRGB with radiance clamped to [0, 1], rows use adaptive filters
+  void savePNG(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution);
+  // half RGB channels with ZIP compression
+  void saveEXR(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution);
+  // format is picked by extension: .png, .pfm or .exr
+  void save(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution);
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <tuple>
+#include <stdexcept>
+
+// pixels are linear radiance, rows are stored top to bottom like in result textures
+// portable float map keeps values unclamped, so CPU and GPU renders can be compared exactly
+void savePFM(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution);
@@ -0,0 +1,58 @@
+#pragma once
+#include "Device.h"
+#include "Query.h"
+#include "Settings.h"
+#include <deque>
+#include <map>
+#include <fstream>
+
+// GPU time of labeled regions of the frame: every region writes begin and end timestamps to own queries of the frame
+// slot, results of the slot are read right after its fence when the slot comes around again, so they are available
+// and reading never stalls; statistics are rolling over the last frames, every frame can be appended to CSV
+class Profiler {
+ private:
+  std::shared_ptr<Device> _device;
+  std::shared_ptr<Settings> _settings;
+  std::shared_ptr<QueryPool> _queryPool;
+  int _regions;
+  bool _supported;
+  // regions get indices in order of the first use, names are unique, queue is the one of the first use
+  std::vector<std::string> _names;
+  std::vector<std::string> _queues;
+  std::map<std::string, int> _indices;
+  // regions written to the frame slot and number of the frame which used the slot
+  std::vector<std::vector<int>> _written;
+  std::vector<int> _frames;
+  std::vector<int> _open;
+  int _frame = 0;
+  // milliseconds of the last frames per region and per queue; queues can run in parallel, so every queue has own
+  // total, which is sum of its regions of a frame
+  std::vector<std::deque<float>> _history;
+  std::map<std::string, std::deque<float>> _totals;
+  int _historySize = 256;
+
+  std::map<std::string, bool*> _checkboxes;
+  bool _enabled = false;
+  std::string _path = "profile.csv";
+  std::ofstream _file;
+
+  void _write(int frame, std::string name, float time);
+
+ public:
+  // regions is the maximum number of distinct region names
+  Profiler(std::shared_ptr<Device> device, std::shared_ptr<Settings> settings, int regions = 16);
+  // reads timestamps of the previous use of the slot, must be called after the slot's fence is waited
+  void resolve(int currentFrame);
+  // resets queries of the slot, must be recorded before any region of the frame, e.g. first in the first submit
+  void reset(VkCommandBuffer commandBuffer, int currentFrame);
+  // queue is a label of the queue the command buffer is submitted to, e.g. "compute" or "graphic"
+  void begin(VkCommandBuffer commandBuffer, int currentFrame, std::string name, std::string queue);
+  // ends the last begun region, regions can be nested but not spread across command buffers
+  void end(VkCommandBuffer commandBuffer, int currentFrame);
+  // one line per region in order of use and "<queue> total" per queue: last, min, avg and p99 time in milliseconds
+  std::vector<std::string> getStatistics();
+  // rows are "frame,region,ms", one per region and queue total of every resolved frame while enabled
+  void setPath(std::string path);
+  void setEnabled(bool enabled);
+  std::map<std::string, bool*> getCheckboxes();
+};
\ No newline at end of file
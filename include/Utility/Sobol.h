@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+// Precomputed points of Sobol sequence as 32-bit fixed point values, scrambling is done per pixel in shader
+class Sobol {
+ private:
+  int _samples;
+  int _dimensions;
+  std::vector<uint32_t> _table;
+
+ public:
+  Sobol(int samples, int dimensions);
+  // dimensions of one sample are consecutive
+  std::vector<uint32_t>& getTable();
+  int getSamples();
+  int getDimensions();
+};
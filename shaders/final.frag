@@ -2,10 +2,13 @@
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in vec2 fragScale;
 
 layout(location = 0) out vec4 outColor;
 layout(binding = 1) uniform sampler2D texSampler;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);    
+    //bilinear upscale, texels outside of rendered part are stale so don't let filter reach them
+    vec2 halfTexel = 0.5f / vec2(textureSize(texSampler, 0));
+    outColor = texture(texSampler, clamp(fragTexCoord, halfTexel, fragScale - halfTexel));
 }
@@ -12,9 +12,13 @@ layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+//rendered part of the texture, see ScreenPart::setExtent
+layout(location = 2) flat out vec2 fragScale;
 
 void main() {
     fragColor = inColor;
-    fragTexCoord = inTexCoord;
-    gl_Position = vec4(fragTexCoord * 2.0f - 1.0f, 0.0f, 1.0f);
-}
\ No newline at end of file
+    //model scales texture coordinates to the rendered part of the texture
+    fragTexCoord = (mvp.model * vec4(inTexCoord, 0.0f, 1.0f)).xy;
+    fragScale = vec2(mvp.model[0][0], mvp.model[1][1]);
+    gl_Position = vec4(inTexCoord * 2.0f - 1.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,39 @@
+//hashed grid shared by the radiance cache and path guiding, tables are power of two arrays of cells which start with
+//uint checksum, 0 marks empty cell; maintenance passes age and evict cells, see ComputePart::_updateHashGrid
+
+uint pcgHash(uint value) {
+  uint state = value * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+//hash of the grid cell containing point, cells double in size with every octave of distance from origin, so their
+//projected size stays roughly the same; extra separates keys of the same cell,
+//checksum distinguishes keys which land in the same slot and is never 0
+void gridKey(vec3 point, vec3 origin, float cellSize, uint extra, out uint hash, out uint checksum) {
+  float level = max(0.0, floor(log2(max(length(point - origin), 1.0))));
+  ivec3 cell = ivec3(floor(point / (cellSize * exp2(level))));
+  hash = pcgHash(uint(cell.x) + pcgHash(uint(cell.y) + pcgHash(uint(cell.z) + pcgHash(extra + uint(level) * 8u))));
+  checksum = max(pcgHash(hash), 1u);
+}
+
+//defines int name(uint hash, uint checksum, bool insert) over cells of table: linear probing, insert claims empty
+//slot with atomic, -1 if the key is absent or the probe window is full
+#define HASH_GRID_FIND(name, table, probes)                               \
+  int name(uint hash, uint checksum, bool insert) {                      \
+    uint capacity = uint(table.length());                                 \
+    for (uint i = 0; i < probes; i++) {                                   \
+      uint slot = (hash + i) & (capacity - 1u);                           \
+      uint stored = table[slot].checksum;                                 \
+      if (stored == checksum)                                             \
+        return int(slot);                                                 \
+      if (stored == 0u) {                                                 \
+        if (insert == false)                                              \
+          return -1;                                                      \
+        stored = atomicCompSwap(table[slot].checksum, 0u, checksum);      \
+        if (stored == 0u || stored == checksum)                           \
+          return int(slot);                                               \
+      }                                                                   \
+    }                                                                     \
+    return -1;                                                            \
+  }
\ No newline at end of file
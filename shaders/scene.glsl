@@ -0,0 +1,125 @@
+//scene layout and ray queries shared by raytracing.comp and restir.comp, buffers must match ComputePart,
+//the including shader defines SPHERES_BINDING and HITBOXES_BINDING
+#define MAX_SPHERES 300
+#define MAX_HITBOXES 300
+
+#define MATERIAL_DIFFUSE 0
+#define MATERIAL_METAL 1
+#define MATERIAL_DIELECTRIC 2
+//attenuation is emitted radiance
+#define MATERIAL_EMISSIVE 3
+
+struct Material {
+  int type;
+  vec3 attenuation;
+  //actual only for metal
+  float fuzz;
+  //actual only for dielectric (etaIn / etaOut)
+  float refraction;
+};
+
+struct Sphere {
+  vec3 center;
+  float radius;
+  int index;
+  //leaf of the light tree for emissive spheres
+  int lightNode;
+  Material material;
+};
+
+layout (binding = SPHERES_BINDING) uniform Spheres {
+  int spheresNumber;
+  Sphere spheres[MAX_SPHERES];
+};
+
+//node of the threaded BVH built by ComputePart, traversal goes to next on hit and to exit on miss
+struct Hitbox {
+  vec3 min;
+  vec3 max;
+  int next;
+  int exit;
+  int sphere;
+};
+
+layout (binding = HITBOXES_BINDING) uniform Hitboxes {
+  int hitboxNumber;
+  Hitbox hitboxes[MAX_HITBOXES];
+};
+
+struct Ray {
+  vec3 origin;
+  vec3 direction;
+};
+
+//t2b⋅b+2tb⋅(A−C)+(A−C)⋅(A−C)−r2=0
+float hitSphere(Ray ray, Sphere sphere, float tMin, float tMax) {
+  vec3 oc = ray.origin - sphere.center;
+  float a = dot(ray.direction, ray.direction);
+  float b = 2 * dot(ray.direction, oc);
+  float c = dot(oc, oc) - sphere.radius * sphere.radius;
+  float disc = b * b - 4 * a * c;
+  if (disc < 0)
+    return -1;
+  float sqrtd = sqrt(disc);
+  float root1 = (-b - sqrtd ) / (2.0*a);
+  if (root1 >= tMin && root1 <= tMax)
+    return root1;
+
+  float root2 = (-b + sqrtd ) / (2.0*a);
+  if (root2 >= tMin && root2 <= tMax)
+    return root2;
+
+  return -1;
+}
+
+bool hitBoundingBox(Ray ray, Hitbox bb, float tMin, float tMax) {
+  vec3 first = (bb.min - ray.origin) / ray.direction;
+  vec3 second = (bb.max - ray.origin) / ray.direction;
+  for (int i = 0; i < 3; i++) {
+    float t0 = min(first[i], second[i]);
+    float t1 = max(first[i], second[i]);
+    tMin = max(t0, tMin);
+    tMax = min(t1, tMax);
+    if (tMax <= tMin)
+      return false;
+  }
+  return true;
+}
+
+//closest hit traversal of the BVH, returns index of the hit sphere or -1, tMax becomes distance to the hit
+int closestHitBVH(Ray ray, float tMin, inout float tMax) {
+  int sphere = -1;
+  int boxIndex = 0;
+  while (boxIndex != -1) {
+    Hitbox current = hitboxes[boxIndex];
+    boxIndex = current.exit;
+    if (hitBoundingBox(ray, current, tMin, tMax)) {
+      boxIndex = current.next;
+      if (current.sphere != -1) {
+        float t = hitSphere(ray, spheres[current.sphere], tMin, tMax);
+        if (t > 0.0) {
+          tMax = t;
+          sphere = current.sphere;
+        }
+      }
+    }
+  }
+
+  return sphere;
+}
+
+//any hit traversal for shadow rays, stops at the first occluder
+bool occludedBVH(Ray ray, float tMin, float tMax) {
+  int boxIndex = 0;
+  while (boxIndex != -1) {
+    Hitbox current = hitboxes[boxIndex];
+    boxIndex = current.exit;
+    if (hitBoundingBox(ray, current, tMin, tMax)) {
+      boxIndex = current.next;
+      if (current.sphere != -1 && hitSphere(ray, spheres[current.sphere], tMin, tMax) > 0.0)
+        return true;
+    }
+  }
+
+  return false;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#version 450
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in vec2 fragScale;
+
+layout(location = 0) out vec4 outColor;
+layout(binding = 1) uniform sampler2D texSampler;
+
+//the bigger the closer result is to nearest filter on edges
+#define SHARPNESS 8.0
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+//edge-aware upscale: bilinear weights of 2x2 footprint are reduced for texels which differ from the nearest one,
+//so flat areas are interpolated and edges stay sharp
+void main() {
+    ivec2 size = textureSize(texSampler, 0);
+    //texels outside of rendered part are stale
+    ivec2 maxTexel = ivec2(fragScale * vec2(size) + 0.5f) - 1;
+    vec2 pixel = fragTexCoord * vec2(size) - 0.5f;
+    ivec2 base = ivec2(floor(pixel));
+    vec2 fraction = pixel - vec2(base);
+
+    vec4 taps[4];
+    float weights[4];
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i % 2, i / 2);
+        taps[i] = texelFetch(texSampler, clamp(base + offset, ivec2(0), maxTexel), 0);
+        weights[i] = (offset.x == 0 ? 1.0f - fraction.x : fraction.x) * (offset.y == 0 ? 1.0f - fraction.y : fraction.y);
+    }
+
+    int nearest = int(fraction.x >= 0.5f) + 2 * int(fraction.y >= 0.5f);
+    float nearestLuminance = luminance(taps[nearest].rgb);
+    vec4 result = vec4(0.0f);
+    float weightSum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        float weight = weights[i] * exp(-abs(luminance(taps[i].rgb) - nearestLuminance) * SHARPNESS);
+        result += taps[i] * weight;
+        weightSum += weight;
+    }
+    //nearest texel always has weight at least 0.25
+    outColor = result / weightSum;
+}
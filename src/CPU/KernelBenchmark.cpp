@@ -0,0 +1,88 @@
+#include "KernelBenchmark.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+KernelBenchmark::KernelBenchmark(std::shared_ptr<Scene> scene, int rays) {
+  _wideBVH = std::make_shared<WideBVH>(scene);
+  // rays start around the camera and spread over the sphere field, so both hits and misses are measured
+  std::mt19937 engine(rays);
+  std::uniform_real_distribution<float> position(-10.f, 10.f);
+  std::uniform_real_distribution<float> direction(-1.f, 1.f);
+  for (int i = 0; i < rays; i++) {
+    glm::vec3 origin(position(engine), 1.f + 0.2f * position(engine), position(engine));
+    glm::vec3 target(position(engine), 0.f, position(engine));
+    glm::vec3 jitter(direction(engine), direction(engine), direction(engine));
+    Ray ray{origin, glm::normalize(target - origin + 0.1f * jitter)};
+    _rays.push_back(ray);
+    _inverseDirections.push_back(1.f / ray.direction);
+  }
+}
+
+std::tuple<float, uint64_t> KernelBenchmark::_benchmarkSpheres(Kernels& kernels, int repeats) {
+  auto& groups = _wideBVH->getSphereGroups();
+  uint64_t checksum = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int repeat = 0; repeat < repeats; repeat++) {
+    for (auto& ray : _rays) {
+      float t;
+      for (int i = 0; i < groups.size(); i++) {
+        int lane = kernels.hitSpheres(ray, groups[i], 0.001f, 1e30f, t);
+        checksum += (lane + 1) * (i + 1);
+      }
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  float seconds = std::chrono::duration<float>(end - start).count();
+  float tests = 8.f * repeats * _rays.size() * groups.size();
+  return {tests / seconds, checksum};
+}
+
+std::tuple<float, uint64_t> KernelBenchmark::_benchmarkBoxes(Kernels& kernels, int repeats) {
+  auto& nodes = _wideBVH->getNodes();
+  uint64_t checksum = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int repeat = 0; repeat < repeats; repeat++) {
+    for (int r = 0; r < _rays.size(); r++) {
+      alignas(32) float tEntry[8];
+      for (int i = 0; i < nodes.size(); i++) {
+        uint32_t mask = kernels.hitBoxes(_rays[r], _inverseDirections[r], nodes[i], 0.001f, 1e30f, tEntry);
+        checksum += mask * (i + 1);
+      }
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  float seconds = std::chrono::duration<float>(end - start).count();
+  float tests = 8.f * repeats * _rays.size() * nodes.size();
+  return {tests / seconds, checksum};
+}
+
+void KernelBenchmark::run(int repeats) {
+  InstructionSet detected = detectInstructionSet();
+  std::cout << "detected instruction set: " << getInstructionSetName(detected) << std::endl;
+  std::cout << "rays: " << _rays.size() << ", sphere groups: " << _wideBVH->getSphereGroups().size()
+            << ", wide nodes: " << _wideBVH->getNodes().size() << std::endl;
+
+  float spheresScalar = 0.f, boxesScalar = 0.f;
+  uint64_t spheresReference = 0, boxesReference = 0;
+  for (int set = 0; set <= static_cast<int>(detected); set++) {
+    Kernels kernels = getKernels(static_cast<InstructionSet>(set));
+    // binary built without the set falls back to narrower kernels, nothing new to measure
+    if (kernels.instructionSet != static_cast<InstructionSet>(set)) continue;
+    auto [spheres, spheresChecksum] = _benchmarkSpheres(kernels, repeats);
+    auto [boxes, boxesChecksum] = _benchmarkBoxes(kernels, repeats);
+    if (kernels.instructionSet == InstructionSet::SCALAR) {
+      spheresScalar = spheres;
+      boxesScalar = boxes;
+      spheresReference = spheresChecksum;
+      boxesReference = boxesChecksum;
+    }
+
+    std::cout << std::fixed << std::setprecision(1) << std::setw(6) << getInstructionSetName(kernels.instructionSet)
+              << " spheres: " << spheres / 1e6f << " Mtests/s (x" << std::setprecision(2) << spheres / spheresScalar
+              << ")" << std::setprecision(1) << ", boxes: " << boxes / 1e6f << " Mtests/s (x" << std::setprecision(2)
+              << boxes / boxesScalar << ")";
+    if (spheresChecksum != spheresReference || boxesChecksum != boxesReference) std::cout << " MISMATCH with scalar";
+    std::cout << std::endl;
+  }
+}
@@ -0,0 +1,119 @@
+#include "Kernels.h"
+#include <algorithm>
+#include <limits>
+#ifdef CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef CPU_X86
+static void cpuid(int leaf, int subleaf, uint32_t registers[4]) {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuidex(info, leaf, subleaf);
+  for (int i = 0; i < 4; i++) registers[i] = info[i];
+#else
+  __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// register state enabled by OS, without YMM bits AVX instructions fault even if CPU has them
+static uint64_t xgetbv() {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+InstructionSet detectInstructionSet() {
+#ifdef CPU_X86
+  uint32_t registers[4];
+  cpuid(0, 0, registers);
+  uint32_t maxLeaf = registers[0];
+  cpuid(1, 0, registers);
+  bool sse41 = registers[2] & (1u << 19);
+  bool osxsave = registers[2] & (1u << 27);
+  bool avx = registers[2] & (1u << 28);
+  bool avx2 = false;
+  if (maxLeaf >= 7) {
+    cpuid(7, 0, registers);
+    avx2 = registers[1] & (1u << 5);
+  }
+  bool ymm = osxsave && avx && (xgetbv() & 0x6) == 0x6;
+  if (avx2 && ymm) return InstructionSet::AVX2;
+  if (sse41) return InstructionSet::SSE4;
+#endif
+  return InstructionSet::SCALAR;
+}
+
+std::string getInstructionSetName(InstructionSet instructionSet) {
+  switch (instructionSet) {
+    case InstructionSet::AVX2:
+      return "AVX2";
+    case InstructionSet::SSE4:
+      return "SSE4";
+    default:
+      return "scalar";
+  }
+}
+
+Kernels getKernels(InstructionSet instructionSet) {
+  // requested set may come from command line, wider kernels than CPU and OS support would fault
+  instructionSet = std::min(instructionSet, detectInstructionSet());
+#ifdef CPU_X86
+  if (instructionSet == InstructionSet::AVX2) return {InstructionSet::AVX2, hitSpheresAVX2, hitBoxesAVX2};
+  if (instructionSet == InstructionSet::SSE4) return {InstructionSet::SSE4, hitSpheresSSE4, hitBoxesSSE4};
+#endif
+  return {InstructionSet::SCALAR, hitSpheresScalar, hitBoxesScalar};
+}
+
+// the same math as hitSphere and hitBoundingBox of raytracing.comp, lane by lane
+int hitSpheresScalar(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t) {
+  int lane = -1;
+  float a = glm::dot(ray.direction, ray.direction);
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 oc = ray.origin - glm::vec3(leaf.centerX[i], leaf.centerY[i], leaf.centerZ[i]);
+    float b = 2 * glm::dot(ray.direction, oc);
+    float c = glm::dot(oc, oc) - leaf.radius2[i];
+    float disc = b * b - 4 * a * c;
+    if (disc < 0) continue;
+    float sqrtd = std::sqrt(disc);
+    float root = (-b - sqrtd) / (2.f * a);
+    if (root < tMin || root > tMax) root = (-b + sqrtd) / (2.f * a);
+    if (root < tMin || root > tMax) continue;
+    // the closest one wins, so later lanes are tested against shortened range, equal distance keeps the first lane
+    if (lane >= 0 && root == tMax) continue;
+    tMax = root;
+    t = root;
+    lane = i;
+  }
+  return lane;
+}
+
+uint32_t hitBoxesScalar(const Ray& ray,
+                        const glm::vec3& inverseDirection,
+                        const WideNode& node,
+                        float tMin,
+                        float tMax,
+                        float* tEntry) {
+  uint32_t mask = 0;
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 first = (glm::vec3(node.minX[i], node.minY[i], node.minZ[i]) - ray.origin) * inverseDirection;
+    glm::vec3 second = (glm::vec3(node.maxX[i], node.maxY[i], node.maxZ[i]) - ray.origin) * inverseDirection;
+    float tNear = tMin, tFar = tMax;
+    for (int axis = 0; axis < 3; axis++) {
+      tNear = std::max(std::min(first[axis], second[axis]), tNear);
+      tFar = std::min(std::max(first[axis], second[axis]), tFar);
+    }
+    tEntry[i] = tNear;
+    if (tNear < tFar) mask |= 1u << i;
+  }
+  return mask;
+}
@@ -0,0 +1,72 @@
+#include "Kernels.h"
+#ifdef CPU_X86
+#include <immintrin.h>
+#include <limits>
+
+// all 8 lanes in one register
+CPU_TARGET_AVX2 int hitSpheresAVX2(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t) {
+  __m256 ocX = _mm256_sub_ps(_mm256_set1_ps(ray.origin.x), _mm256_load_ps(leaf.centerX));
+  __m256 ocY = _mm256_sub_ps(_mm256_set1_ps(ray.origin.y), _mm256_load_ps(leaf.centerY));
+  __m256 ocZ = _mm256_sub_ps(_mm256_set1_ps(ray.origin.z), _mm256_load_ps(leaf.centerZ));
+  __m256 directionX = _mm256_set1_ps(ray.direction.x);
+  __m256 directionY = _mm256_set1_ps(ray.direction.y);
+  __m256 directionZ = _mm256_set1_ps(ray.direction.z);
+
+  float aScalar = glm::dot(ray.direction, ray.direction);
+  __m256 a = _mm256_set1_ps(aScalar);
+  __m256 twoA = _mm256_set1_ps(2.f * aScalar);
+  __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(directionX, ocX), _mm256_mul_ps(directionY, ocY)),
+                           _mm256_mul_ps(directionZ, ocZ));
+  b = _mm256_add_ps(b, b);
+  __m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocX, ocX), _mm256_mul_ps(ocY, ocY)), _mm256_mul_ps(ocZ, ocZ));
+  c = _mm256_sub_ps(c, _mm256_load_ps(leaf.radius2));
+  __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_set1_ps(4.f), _mm256_mul_ps(a, c)));
+  __m256 valid = _mm256_cmp_ps(disc, _mm256_setzero_ps(), _CMP_GE_OQ);
+  __m256 sqrtd = _mm256_sqrt_ps(_mm256_max_ps(disc, _mm256_setzero_ps()));
+  __m256 minusB = _mm256_sub_ps(_mm256_setzero_ps(), b);
+  __m256 root1 = _mm256_div_ps(_mm256_sub_ps(minusB, sqrtd), twoA);
+  __m256 root2 = _mm256_div_ps(_mm256_add_ps(minusB, sqrtd), twoA);
+
+  __m256 low = _mm256_set1_ps(tMin);
+  __m256 high = _mm256_set1_ps(tMax);
+  __m256 inside1 = _mm256_and_ps(_mm256_cmp_ps(root1, low, _CMP_GE_OQ), _mm256_cmp_ps(root1, high, _CMP_LE_OQ));
+  __m256 inside2 = _mm256_and_ps(_mm256_cmp_ps(root2, low, _CMP_GE_OQ), _mm256_cmp_ps(root2, high, _CMP_LE_OQ));
+  __m256 infinity = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  __m256 root = _mm256_blendv_ps(_mm256_blendv_ps(infinity, root2, inside2), root1, inside1);
+  root = _mm256_blendv_ps(infinity, root, _mm256_and_ps(valid, _mm256_or_ps(inside1, inside2)));
+
+  int hits = _mm256_movemask_ps(_mm256_cmp_ps(root, infinity, _CMP_LT_OQ));
+  if (hits == 0) return -1;
+  // horizontal minimum, then the first lane which has it
+  __m256 minimum = _mm256_min_ps(root, _mm256_permute2f128_ps(root, root, 1));
+  minimum = _mm256_min_ps(minimum, _mm256_shuffle_ps(minimum, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+  minimum = _mm256_min_ps(minimum, _mm256_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+  int lanes = _mm256_movemask_ps(_mm256_cmp_ps(root, minimum, _CMP_EQ_OQ)) & hits;
+  t = _mm_cvtss_f32(_mm256_castps256_ps128(minimum));
+  int lane = 0;
+  while ((lanes & (1 << lane)) == 0) lane++;
+  return lane;
+}
+
+CPU_TARGET_AVX2 uint32_t hitBoxesAVX2(const Ray& ray,
+                                      const glm::vec3& inverseDirection,
+                                      const WideNode& node,
+                                      float tMin,
+                                      float tMax,
+                                      float* tEntry) {
+  __m256 tNear = _mm256_set1_ps(tMin);
+  __m256 tFar = _mm256_set1_ps(tMax);
+  const float* minimums[3] = {node.minX, node.minY, node.minZ};
+  const float* maximums[3] = {node.maxX, node.maxY, node.maxZ};
+  for (int axis = 0; axis < 3; axis++) {
+    __m256 origin = _mm256_set1_ps(ray.origin[axis]);
+    __m256 inverse = _mm256_set1_ps(inverseDirection[axis]);
+    __m256 first = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(minimums[axis]), origin), inverse);
+    __m256 second = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(maximums[axis]), origin), inverse);
+    tNear = _mm256_max_ps(_mm256_min_ps(first, second), tNear);
+    tFar = _mm256_min_ps(_mm256_max_ps(first, second), tFar);
+  }
+  _mm256_storeu_ps(tEntry, tNear);
+  return _mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LT_OQ));
+}
+#endif
@@ -0,0 +1,89 @@
+#include "Kernels.h"
+#ifdef CPU_X86
+#include <smmintrin.h>
+#include <limits>
+
+// 8 lanes as two halves of 4, the closest hit of both halves wins
+CPU_TARGET_SSE4 int hitSpheresSSE4(const Ray& ray, const SphereLeaf& leaf, float tMin, float tMax, float& t) {
+  __m128 originX = _mm_set1_ps(ray.origin.x);
+  __m128 originY = _mm_set1_ps(ray.origin.y);
+  __m128 originZ = _mm_set1_ps(ray.origin.z);
+  __m128 directionX = _mm_set1_ps(ray.direction.x);
+  __m128 directionY = _mm_set1_ps(ray.direction.y);
+  __m128 directionZ = _mm_set1_ps(ray.direction.z);
+  float aScalar = glm::dot(ray.direction, ray.direction);
+  __m128 a = _mm_set1_ps(aScalar);
+  __m128 twoA = _mm_set1_ps(2.f * aScalar);
+  __m128 low = _mm_set1_ps(tMin);
+  __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+
+  int lane = -1;
+  for (int half = 0; half < 2; half++) {
+    int offset = half * 4;
+    __m128 ocX = _mm_sub_ps(originX, _mm_load_ps(leaf.centerX + offset));
+    __m128 ocY = _mm_sub_ps(originY, _mm_load_ps(leaf.centerY + offset));
+    __m128 ocZ = _mm_sub_ps(originZ, _mm_load_ps(leaf.centerZ + offset));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, ocX), _mm_mul_ps(directionY, ocY)),
+                          _mm_mul_ps(directionZ, ocZ));
+    b = _mm_add_ps(b, b);
+    __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocX, ocX), _mm_mul_ps(ocY, ocY)), _mm_mul_ps(ocZ, ocZ));
+    c = _mm_sub_ps(c, _mm_load_ps(leaf.radius2 + offset));
+    __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_set1_ps(4.f), _mm_mul_ps(a, c)));
+    __m128 valid = _mm_cmpge_ps(disc, _mm_setzero_ps());
+    __m128 sqrtd = _mm_sqrt_ps(_mm_max_ps(disc, _mm_setzero_ps()));
+    __m128 minusB = _mm_sub_ps(_mm_setzero_ps(), b);
+    __m128 root1 = _mm_div_ps(_mm_sub_ps(minusB, sqrtd), twoA);
+    __m128 root2 = _mm_div_ps(_mm_add_ps(minusB, sqrtd), twoA);
+
+    // the second half is tested against range shortened by the first one
+    __m128 high = _mm_set1_ps(tMax);
+    __m128 inside1 = _mm_and_ps(_mm_cmpge_ps(root1, low), _mm_cmple_ps(root1, high));
+    __m128 inside2 = _mm_and_ps(_mm_cmpge_ps(root2, low), _mm_cmple_ps(root2, high));
+    __m128 root = _mm_blendv_ps(_mm_blendv_ps(infinity, root2, inside2), root1, inside1);
+    root = _mm_blendv_ps(infinity, root, _mm_and_ps(valid, _mm_or_ps(inside1, inside2)));
+
+    int hits = _mm_movemask_ps(_mm_cmplt_ps(root, infinity));
+    if (hits == 0) continue;
+    __m128 minimum = _mm_min_ps(root, _mm_shuffle_ps(root, root, _MM_SHUFFLE(1, 0, 3, 2)));
+    minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+    int lanes = _mm_movemask_ps(_mm_cmpeq_ps(root, minimum)) & hits;
+    // equal distance keeps the lane of the first half, like the first lane of the minimum within a half
+    if (lane >= 0 && _mm_cvtss_f32(minimum) == tMax) continue;
+    tMax = _mm_cvtss_f32(minimum);
+    t = tMax;
+    lane = offset;
+    while ((lanes & 1) == 0) {
+      lanes >>= 1;
+      lane++;
+    }
+  }
+  return lane;
+}
+
+CPU_TARGET_SSE4 uint32_t hitBoxesSSE4(const Ray& ray,
+                                      const glm::vec3& inverseDirection,
+                                      const WideNode& node,
+                                      float tMin,
+                                      float tMax,
+                                      float* tEntry) {
+  const float* minimums[3] = {node.minX, node.minY, node.minZ};
+  const float* maximums[3] = {node.maxX, node.maxY, node.maxZ};
+  uint32_t mask = 0;
+  for (int half = 0; half < 2; half++) {
+    int offset = half * 4;
+    __m128 tNear = _mm_set1_ps(tMin);
+    __m128 tFar = _mm_set1_ps(tMax);
+    for (int axis = 0; axis < 3; axis++) {
+      __m128 origin = _mm_set1_ps(ray.origin[axis]);
+      __m128 inverse = _mm_set1_ps(inverseDirection[axis]);
+      __m128 first = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minimums[axis] + offset), origin), inverse);
+      __m128 second = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maximums[axis] + offset), origin), inverse);
+      tNear = _mm_max_ps(_mm_min_ps(first, second), tNear);
+      tFar = _mm_min_ps(_mm_max_ps(first, second), tFar);
+    }
+    _mm_storeu_ps(tEntry + offset, tNear);
+    mask |= _mm_movemask_ps(_mm_cmplt_ps(tNear, tFar)) << offset;
+  }
+  return mask;
+}
+#endif
@@ -0,0 +1,874 @@
+#include "PathTracer.h"
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <bit>
+
+// functions below repeat the ones of raytracing.comp with the same names, keep them in sync
+
+// https://github.com/GPSnoopy/RayTracingInVulkan/blob/master/assets/shaders/Random.glsl
+uint32_t initRandomSeed(uint32_t val0, uint32_t val1) {
+  uint32_t v0 = val0, v1 = val1, s0 = 0;
+  for (uint32_t n = 0; n < 16; n++) {
+    s0 += 0x9e3779b9;
+    v0 += ((v1 << 4) + 0xa341316c) ^ (v1 + s0) ^ ((v1 >> 5) + 0xc8013ea4);
+    v1 += ((v0 << 4) + 0xad90777d) ^ (v0 + s0) ^ ((v0 >> 5) + 0x7e95761e);
+  }
+  return v0;
+}
+
+uint32_t hashCombine(uint32_t seed, uint32_t v) { return seed ^ (v + (seed << 6) + (seed >> 2)); }
+
+uint32_t bitfieldReverse(uint32_t x) {
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+  x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return x;
+}
+
+uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+  return bitfieldReverse(laineKarrasPermutation(bitfieldReverse(x), seed));
+}
+
+glm::vec3 randomUnitVector(glm::vec2 u) {
+  float z = 1.f - 2.f * u.x;
+  float r = std::sqrt(std::max(0.f, 1.f - z * z));
+  float phi = 2.f * glm::pi<float>() * u.y;
+  return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+glm::vec3 randomInUnitSphere(glm::vec3 u) { return randomUnitVector(glm::vec2(u)) * std::pow(u.z, 1.f / 3.f); }
+
+// Schlick's approximation
+float reflectance(float cosine, float refraction) {
+  float r0 = (1 - refraction) / (1 + refraction);
+  r0 = r0 * r0;
+  return r0 + (1 - r0) * std::pow((1 - cosine), 5.f);
+}
+
+glm::vec3 refractRay(glm::vec3 direction, glm::vec3 normal, float refraction) {
+  float angleCos = std::min(glm::dot(-direction, normal), 1.f);
+  glm::vec3 perpPart = refraction * (direction + angleCos * normal);
+  glm::vec3 parallelPart = -std::sqrt(std::abs(1.f - glm::dot(perpPart, perpPart))) * normal;
+  return perpPart + parallelPart;
+}
+
+glm::vec3 reflectRay(glm::vec3 v, glm::vec3 n) { return v - 2 * glm::dot(v, n) * n; }
+
+bool nearZero(glm::vec3 v) {
+  float s = 1e-8f;
+  return (std::abs(v.x) < s) && (std::abs(v.y) < s) && (std::abs(v.z) < s);
+}
+
+// glass doesn't attenuate, like in the GPU version
+bool dielectricMaterial(HitRecord& hitRecord, glm::vec4 u, Ray& ray) {
+  glm::vec3 normal = hitRecord.normal;
+  float refraction = hitRecord.material.refraction;
+  // ray is inside the sphere
+  if (hitRecord.frontFace == false) refraction = 1 / hitRecord.material.refraction;
+
+  float angleCos = std::min(glm::dot(-ray.direction, normal), 1.f);
+  float angleSin = std::sqrt(1.f - angleCos * angleCos);
+  bool cannotRefract = refraction * angleSin > 1.f;
+  glm::vec3 direction;
+  // reflectance is treated as probability of reflection
+  if (cannotRefract || reflectance(angleCos, refraction) > u.z)
+    direction = reflectRay(ray.direction, normal);
+  else
+    direction = refractRay(ray.direction, normal, refraction);
+
+  ray = Ray{hitRecord.point, glm::normalize(direction)};
+  return true;
+}
+
+bool metalMaterial(HitRecord& hitRecord, glm::vec4 u, Ray& ray, glm::vec3& color) {
+  glm::vec3 direction = reflectRay(ray.direction, hitRecord.normal);
+  ray = Ray{hitRecord.point,
+            glm::normalize(direction + hitRecord.material.fuzz * randomInUnitSphere(glm::vec3(u)))};
+  color *= hitRecord.material.attenuation;
+  return glm::dot(direction, hitRecord.normal) > 0;
+}
+
+bool diffuseMaterial(HitRecord& hitRecord, glm::vec4 u, Ray& ray, glm::vec3& color) {
+  // normal + unit vector gives cosine weighted direction
+  glm::vec3 direction = hitRecord.normal + randomUnitVector(glm::vec2(u));
+  if (nearZero(direction)) direction = hitRecord.normal;
+  ray = Ray{hitRecord.point, glm::normalize(direction)};
+  color *= hitRecord.material.attenuation;
+  return true;
+}
+
+float hitSphere(Ray& ray, UniformSphere& sphere, float tMin, float tMax) {
+  glm::vec3 oc = ray.origin - sphere.center;
+  float a = glm::dot(ray.direction, ray.direction);
+  float b = 2 * glm::dot(ray.direction, oc);
+  float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+  float disc = b * b - 4 * a * c;
+  if (disc < 0) return -1;
+  float sqrtd = std::sqrt(disc);
+  float root1 = (-b - sqrtd) / (2.f * a);
+  if (root1 >= tMin && root1 <= tMax) return root1;
+  float root2 = (-b + sqrtd) / (2.f * a);
+  if (root2 >= tMin && root2 <= tMax) return root2;
+  return -1;
+}
+
+bool hitBoundingBox(Ray& ray, HitBox& bb, float tMin, float tMax) {
+  glm::vec3 first = (bb.min - ray.origin) / ray.direction;
+  glm::vec3 second = (bb.max - ray.origin) / ray.direction;
+  for (int i = 0; i < 3; i++) {
+    float t0 = std::min(first[i], second[i]);
+    float t1 = std::max(first[i], second[i]);
+    tMin = std::max(t0, tMin);
+    tMax = std::min(t1, tMax);
+    if (tMax <= tMin) return false;
+  }
+  return true;
+}
+
+void fillHitRecord(Ray& ray, UniformSphere& sphere, int index, float t, HitRecord& hitRecord) {
+  hitRecord.t = t;
+  hitRecord.sphere = index;
+  hitRecord.material = sphere.material;
+  hitRecord.point = ray.origin + ray.direction * t;
+  hitRecord.normal = (hitRecord.point - sphere.center) / sphere.radius;
+  // normal is always against the ray, front face tells from which side ray came
+  hitRecord.frontFace = true;
+  if (glm::dot(ray.direction, hitRecord.normal) > 0) {
+    hitRecord.normal = -hitRecord.normal;
+    hitRecord.frontFace = false;
+  }
+}
+
+float powerHeuristic(float pdf, float otherPdf) { return (pdf * pdf) / (pdf * pdf + otherPdf * otherPdf); }
+
+float lightCone(glm::vec3 point, UniformSphere& light) {
+  glm::vec3 toCenter = light.center - point;
+  float sinThetaMax2 = light.radius * light.radius / glm::dot(toCenter, toCenter);
+  if (sinThetaMax2 < 1e-3f) return 0.5f * sinThetaMax2;
+  return 1.f - std::sqrt(std::max(0.f, 1.f - sinThetaMax2));
+}
+
+float lightImportance(glm::vec3 point, glm::vec3 normal, LightNode& node) {
+  glm::vec3 toCenter = 0.5f * (node.min + node.max) - point;
+  glm::vec3 size = node.max - node.min;
+  float radius2 = 0.25f * glm::dot(size, size);
+  float distance2 = glm::dot(toCenter, toCenter);
+  if (distance2 <= radius2) return node.power / radius2;
+
+  float cosTheta = glm::dot(normal, toCenter) / std::sqrt(distance2);
+  float sinBound2 = radius2 / distance2;
+  float cosBound = std::sqrt(1.f - sinBound2);
+  float cosSurface = 1.f;
+  if (cosTheta < cosBound) {
+    float sinTheta = std::sqrt(std::max(0.f, 1.f - cosTheta * cosTheta));
+    cosSurface = std::max(0.f, cosTheta * cosBound + sinTheta * std::sqrt(sinBound2));
+  }
+  return node.power * cosSurface / distance2;
+}
+
+float lightLeftProbability(glm::vec3 point, glm::vec3 normal, std::vector<LightNode>& nodes, LightNode& node) {
+  float left = lightImportance(point, normal, nodes[node.left]);
+  float right = lightImportance(point, normal, nodes[node.right]);
+  if (left + right <= 0.f) return -1.f;
+  return left / (left + right);
+}
+
+int pickLightNode(glm::vec3 point, glm::vec3 normal, std::vector<LightNode>& nodes, float u, float& pmf) {
+  pmf = 1.f;
+  int nodeIndex = 0;
+  while (nodes[nodeIndex].light == -1) {
+    auto& node = nodes[nodeIndex];
+    float probability = lightLeftProbability(point, normal, nodes, node);
+    if (probability < 0.f) return -1;
+    if (u < probability) {
+      u = u / probability;
+      nodeIndex = node.left;
+      pmf *= probability;
+    } else {
+      u = (u - probability) / (1.f - probability);
+      nodeIndex = node.right;
+      pmf *= 1.f - probability;
+    }
+    u = std::min(u, 0.99999994f);
+  }
+  return nodeIndex;
+}
+
+float lightNodePmf(glm::vec3 point, glm::vec3 normal, std::vector<LightNode>& nodes, int nodeIndex) {
+  float pmf = 1.f;
+  while (nodes[nodeIndex].parent != -1) {
+    auto& parent = nodes[nodes[nodeIndex].parent];
+    float probability = lightLeftProbability(point, normal, nodes, parent);
+    if (probability < 0.f) return 0.f;
+    pmf *= parent.left == nodeIndex ? probability : 1.f - probability;
+    nodeIndex = nodes[nodeIndex].parent;
+  }
+  return pmf;
+}
+
+// depth of camera rays which escape to the sky, the same as FAR_DEPTH of raytracing.comp
+constexpr float farDepth = 10000.f;
+
+// camera rays of 4x4 pixel blocks make one packet
+constexpr int packetSide = 4;
+constexpr int packetSize = packetSide * packetSide;
+
+int firstBit(uint32_t mask) { return std::countr_zero(mask); }
+
+// lanes of children which are hit by lanes with rays, ordered by the nearest entry of their rays
+int sortChildren(uint32_t childRays[8], float nearest[8], int order[8]) {
+  int count = 0;
+  for (int lane = 0; lane < 8; lane++) {
+    if (childRays[lane] == 0) continue;
+    int position = count++;
+    while (position > 0 && nearest[order[position - 1]] > nearest[lane]) {
+      order[position] = order[position - 1];
+      position--;
+    }
+    order[position] = lane;
+  }
+  return count;
+}
+
+// interval arithmetic version of hitBoxes: bounds of slab distances over all origins and inverse directions of
+// a packet, lane is culled only if no ray of the packet can hit its box; lanes are the inner loop, so it vectorizes
+uint32_t frustumLanes(const WideNode& node,
+                      glm::vec3 originMin,
+                      glm::vec3 originMax,
+                      glm::vec3 inverseMin,
+                      glm::vec3 inverseMax,
+                      float tMin,
+                      float tMax) {
+  const float* minimums[3] = {node.minX, node.minY, node.minZ};
+  const float* maximums[3] = {node.maxX, node.maxY, node.maxZ};
+  float tNear[8], tFar[8];
+  std::fill(tNear, tNear + 8, tMin);
+  std::fill(tFar, tFar + 8, tMax);
+  for (int axis = 0; axis < 3; axis++) {
+    // direction doesn't change sign inside the packet, so near and far slabs are the same for all its rays
+    bool positive = inverseMin[axis] > 0.f;
+    const float* nearBounds = positive ? minimums[axis] : maximums[axis];
+    const float* farBounds = positive ? maximums[axis] : minimums[axis];
+    float low = inverseMin[axis], high = inverseMax[axis];
+    for (int lane = 0; lane < 8; lane++) {
+      float nearMin = nearBounds[lane] - originMax[axis], nearMax = nearBounds[lane] - originMin[axis];
+      float farMin = farBounds[lane] - originMax[axis], farMax = farBounds[lane] - originMin[axis];
+      float nearBound = std::min(std::min(nearMin * low, nearMin * high), std::min(nearMax * low, nearMax * high));
+      float farBound = std::max(std::max(farMin * low, farMin * high), std::max(farMax * low, farMax * high));
+      tNear[lane] = std::max(tNear[lane], nearBound);
+      tFar[lane] = std::min(tFar[lane], farBound);
+    }
+  }
+  uint32_t lanes = 0;
+  for (int lane = 0; lane < 8; lane++) lanes |= static_cast<uint32_t>(tNear[lane] < tFar[lane]) << lane;
+  return lanes;
+}
+
+PathTracer::PathTracer(std::shared_ptr<Scene> scene,
+                       std::shared_ptr<TileScheduler> scheduler,
+                       std::tuple<int, int> resolution) {
+  _scene = scene;
+  _scheduler = scheduler;
+  _resolution = resolution;
+  _result.resize(std::get<0>(resolution) * std::get<1>(resolution), glm::vec4(0.f));
+  _albedo.resize(_result.size(), glm::vec4(0.f));
+  _normalDepth.resize(_result.size(), glm::vec4(0.f));
+  _rays.resize(scheduler->getThreads());
+  _wideBVH = std::make_shared<WideBVH>(scene);
+  _kernels = getKernels(detectInstructionSet());
+  // the same table as the one uploaded by ComputePart, so both backends take the same samples
+  Sobol sobol(4096, 4);
+  _sobol = sobol.getTable();
+  _sobolSamples = sobol.getSamples();
+}
+
+void PathTracer::setAASamples(int aaSamples) { _aaSamples = aaSamples; }
+
+void PathTracer::setMaxDepth(int maxDepth) { _maxDepth = maxDepth; }
+
+void PathTracer::setBVH(bool useBVH) { _useBVH = useBVH; }
+
+void PathTracer::setNEE(bool useNEE) { _useNEE = useNEE; }
+
+void PathTracer::setLightBVH(bool useLightBVH) { _useLightBVH = useLightBVH; }
+
+void PathTracer::setInstructionSet(InstructionSet instructionSet) { _kernels = getKernels(instructionSet); }
+
+InstructionSet PathTracer::getInstructionSet() { return _kernels.instructionSet; }
+
+void PathTracer::setTraversal(TraversalMode traversal) { _traversal = traversal; }
+
+glm::vec4 PathTracer::_sobolSample(SampleState& state, uint32_t dimensionSet) {
+  uint32_t seed = hashCombine(state.pixelSeed, dimensionSet);
+  uint32_t shuffled = nestedUniformScramble(state.sampleIndex, seed) & (_sobolSamples - 1);
+  glm::vec4 result;
+  for (int i = 0; i < 4; i++) {
+    uint32_t value = nestedUniformScramble(_sobol[shuffled * 4 + i], hashCombine(seed, i));
+    result[i] = static_cast<float>(value >> 8) / static_cast<float>(0x01000000);
+  }
+  return result;
+}
+
+int PathTracer::_hitWorldWide(Ray& ray, float tMin, float& tMax) {
+  int hit = -1;
+  float t;
+  if (_useBVH == false) {
+    for (auto& group : _wideBVH->getSphereGroups()) {
+      int lane = _kernels.hitSpheres(ray, group, tMin, tMax, t);
+      if (lane >= 0) {
+        tMax = t;
+        hit = group.sphere[lane];
+      }
+    }
+    return hit;
+  }
+
+  auto& nodes = _wideBVH->getNodes();
+  auto& leaves = _wideBVH->getLeaves();
+  glm::vec3 inverseDirection = 1.f / ray.direction;
+  int stack[WideBVH::stackSize];
+  int size = 0;
+  stack[size++] = _wideBVH->getRoot();
+  while (size > 0) {
+    int current = stack[--size];
+    if (current < 0) {
+      auto& leaf = leaves[~current];
+      int lane = _kernels.hitSpheres(ray, leaf, tMin, tMax, t);
+      if (lane >= 0) {
+        tMax = t;
+        hit = leaf.sphere[lane];
+      }
+      continue;
+    }
+
+    auto& node = nodes[current];
+    alignas(32) float tEntry[8];
+    uint32_t mask = _kernels.hitBoxes(ray, inverseDirection, node, tMin, tMax, tEntry);
+    uint32_t hits[8];
+    for (int lane = 0; lane < 8; lane++) hits[lane] = mask & (1u << lane);
+    // far children are pushed first, so the near ones are visited first and shorten the range for the rest
+    int order[8];
+    int count = sortChildren(hits, tEntry, order);
+    for (int i = count - 1; i >= 0; i--) stack[size++] = node.child[order[i]];
+  }
+  return hit;
+}
+
+bool PathTracer::_occludedWide(Ray& ray, float tMin, float tMax) {
+  float t;
+  if (_useBVH == false) {
+    for (auto& group : _wideBVH->getSphereGroups()) {
+      if (_kernels.hitSpheres(ray, group, tMin, tMax, t) >= 0) return true;
+    }
+    return false;
+  }
+
+  auto& nodes = _wideBVH->getNodes();
+  auto& leaves = _wideBVH->getLeaves();
+  glm::vec3 inverseDirection = 1.f / ray.direction;
+  int stack[WideBVH::stackSize];
+  int size = 0;
+  stack[size++] = _wideBVH->getRoot();
+  while (size > 0) {
+    int current = stack[--size];
+    if (current < 0) {
+      if (_kernels.hitSpheres(ray, leaves[~current], tMin, tMax, t) >= 0) return true;
+      continue;
+    }
+    auto& node = nodes[current];
+    alignas(32) float tEntry[8];
+    uint32_t mask = _kernels.hitBoxes(ray, inverseDirection, node, tMin, tMax, tEntry);
+    for (int lane = 0; lane < 8; lane++) {
+      if (mask & (1u << lane)) stack[size++] = node.child[lane];
+    }
+  }
+  return false;
+}
+
+bool PathTracer::_hitWorld(Ray ray, float tMin, float tMax, HitRecord& hitRecord) {
+  auto& spheres = _scene->getSpheres();
+  if (_kernels.instructionSet != InstructionSet::SCALAR) {
+    int sphere = _hitWorldWide(ray, tMin, tMax);
+    if (sphere < 0) return false;
+    fillHitRecord(ray, spheres.spheres[sphere], sphere, tMax, hitRecord);
+    return true;
+  }
+
+  bool hit = false;
+  if (_useBVH) {
+    auto& hitboxes = _scene->getHitboxes();
+    int boxIndex = 0;
+    while (boxIndex != -1) {
+      auto& current = hitboxes.hitbox[boxIndex];
+      boxIndex = current.exit;
+      if (hitBoundingBox(ray, current, tMin, tMax)) {
+        boxIndex = current.next;
+        if (current.sphere != -1) {
+          float t = hitSphere(ray, spheres.spheres[current.sphere], tMin, tMax);
+          if (t > 0.f) {
+            fillHitRecord(ray, spheres.spheres[current.sphere], current.sphere, t, hitRecord);
+            tMax = t;
+            hit = true;
+          }
+        }
+      }
+    }
+    return hit;
+  }
+
+  for (int i = 0; i < spheres.number; i++) {
+    float t = hitSphere(ray, spheres.spheres[i], tMin, tMax);
+    if (t > 0.f) {
+      fillHitRecord(ray, spheres.spheres[i], i, t, hitRecord);
+      tMax = t;
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+bool PathTracer::_occluded(Ray ray, float tMin, float tMax) {
+  if (_kernels.instructionSet != InstructionSet::SCALAR) return _occludedWide(ray, tMin, tMax);
+  auto& spheres = _scene->getSpheres();
+  if (_useBVH) {
+    auto& hitboxes = _scene->getHitboxes();
+    int boxIndex = 0;
+    while (boxIndex != -1) {
+      auto& current = hitboxes.hitbox[boxIndex];
+      boxIndex = current.exit;
+      if (hitBoundingBox(ray, current, tMin, tMax)) {
+        boxIndex = current.next;
+        if (current.sphere != -1 && hitSphere(ray, spheres.spheres[current.sphere], tMin, tMax) > 0.f) return true;
+      }
+    }
+    return false;
+  }
+
+  for (int i = 0; i < spheres.number; i++) {
+    if (hitSphere(ray, spheres.spheres[i], tMin, tMax) > 0.f) return true;
+  }
+  return false;
+}
+
+float PathTracer::_lightPdf(glm::vec3 point, glm::vec3 normal, UniformSphere& light) {
+  float pmf;
+  if (_useLightBVH)
+    pmf = lightNodePmf(point, normal, _scene->getLightTree(), light.lightNode);
+  else
+    pmf = 1.f / static_cast<float>(_scene->getLights()[0]);
+  return pmf / (2.f * glm::pi<float>() * lightCone(point, light));
+}
+
+glm::vec3 PathTracer::_sampleLight(HitRecord& hitRecord, glm::vec3 u, uint64_t& rays) {
+  auto& lights = _scene->getLights();
+  auto& lightTree = _scene->getLightTree();
+  auto& spheres = _scene->getSpheres();
+  int lightsNumber = lights[0];
+  if (lightsNumber == 0) return glm::vec3(0.f);
+
+  float pmf;
+  int lightIndex;
+  if (_useLightBVH) {
+    int nodeIndex = pickLightNode(hitRecord.point, hitRecord.normal, lightTree, u.x, pmf);
+    if (nodeIndex == -1) return glm::vec3(0.f);
+    lightIndex = lightTree[nodeIndex].light;
+  } else {
+    lightIndex = lights[1 + std::min(static_cast<int>(u.x * lightsNumber), lightsNumber - 1)];
+    pmf = 1.f / static_cast<float>(lightsNumber);
+  }
+  auto& light = spheres.spheres[lightIndex];
+  glm::vec3 toCenter = light.center - hitRecord.point;
+  if (glm::dot(toCenter, toCenter) <= light.radius * light.radius) return glm::vec3(0.f);
+
+  // uniform direction inside the cone around direction to the center
+  float oneMinusCosThetaMax = lightCone(hitRecord.point, light);
+  float cosTheta = 1.f - u.y * oneMinusCosThetaMax;
+  float sinTheta = std::sqrt(std::max(0.f, 1.f - cosTheta * cosTheta));
+  float phi = 2.f * glm::pi<float>() * u.z;
+  glm::vec3 w = glm::normalize(toCenter);
+  glm::vec3 tangent = glm::normalize(
+      glm::cross(std::abs(w.x) > 0.9f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f), w));
+  glm::vec3 bitangent = glm::cross(w, tangent);
+  glm::vec3 direction = glm::normalize(tangent * std::cos(phi) * sinTheta + bitangent * std::sin(phi) * sinTheta +
+                                       w * cosTheta);
+
+  float cosSurface = glm::dot(direction, hitRecord.normal);
+  if (cosSurface <= 0.f) return glm::vec3(0.f);
+
+  Ray shadowRay{hitRecord.point, direction};
+  float t = hitSphere(shadowRay, light, 0.001f, 100000.f);
+  if (t < 0.f) return glm::vec3(0.f);
+  rays++;
+  if (_occluded(shadowRay, 0.001f, t - 0.001f)) return glm::vec3(0.f);
+
+  float pdf = pmf / (2.f * glm::pi<float>() * oneMinusCosThetaMax);
+  float bsdfPdf = std::max(cosSurface, 0.f) / glm::pi<float>();
+  glm::vec3 bsdf = hitRecord.material.attenuation / glm::pi<float>();
+  return light.material.attenuation * bsdf * cosSurface / pdf * powerHeuristic(pdf, bsdfPdf);
+}
+
+TraversalMode PathTracer::_chooseTraversal(std::vector<PathState>& paths, std::vector<int>& active) {
+  // without BVH wide traversal is brute force as well, nothing to share
+  if (_useBVH == false) return TraversalMode::SINGLE;
+  if (_traversal != TraversalMode::AUTO) return _traversal;
+  if (active.size() < packetSize) return TraversalMode::SINGLE;
+
+  // length of the average direction of every packet: 1 if its rays are parallel, near 0 after diffuse bounces
+  float coherence = 0.f;
+  int packets = 0;
+  for (int i = 0; i < active.size(); i += packetSize) {
+    int count = std::min(packetSize, static_cast<int>(active.size()) - i);
+    glm::vec3 sum(0.f);
+    for (int j = 0; j < count; j++) sum += paths[active[i + j]].ray.direction;
+    coherence += glm::length(sum) / count;
+    packets++;
+  }
+  coherence /= packets;
+  if (coherence >= _packetCoherence) return TraversalMode::PACKET;
+  return TraversalMode::STREAM;
+}
+
+void PathTracer::_intersectPacket(std::vector<PathState>& paths, const int* indices, int count) {
+  auto& nodes = _wideBVH->getNodes();
+  auto& leaves = _wideBVH->getLeaves();
+  // interval frustum of the packet, only valid if no direction component changes sign inside it
+  glm::vec3 originMin(std::numeric_limits<float>::max()), originMax(-std::numeric_limits<float>::max());
+  glm::vec3 inverseMin = originMin, inverseMax = originMax;
+  for (int i = 0; i < count; i++) {
+    auto& path = paths[indices[i]];
+    originMin = glm::min(originMin, path.ray.origin);
+    originMax = glm::max(originMax, path.ray.origin);
+    inverseMin = glm::min(inverseMin, path.inverseDirection);
+    inverseMax = glm::max(inverseMax, path.inverseDirection);
+  }
+  bool frustum = true;
+  for (int axis = 0; axis < 3; axis++) {
+    if (inverseMin[axis] < 0.f && inverseMax[axis] > 0.f) frustum = false;
+    if (std::isfinite(inverseMin[axis]) == false || std::isfinite(inverseMax[axis]) == false) frustum = false;
+  }
+
+  // every stack entry keeps the rays which hit the node
+  struct Entry {
+    int node;
+    uint32_t rays;
+  };
+  Entry stack[WideBVH::stackSize];
+  int size = 0;
+  stack[size++] = {_wideBVH->getRoot(), (1u << count) - 1};
+  while (size > 0) {
+    auto [current, rays] = stack[--size];
+    if (current < 0) {
+      auto& leaf = leaves[~current];
+      for (; rays != 0; rays &= rays - 1) {
+        auto& path = paths[indices[firstBit(rays)]];
+        float t;
+        int lane = _kernels.hitSpheres(path.ray, leaf, 0.001f, path.t, t);
+        if (lane >= 0) {
+          path.t = t;
+          path.sphere = leaf.sphere[lane];
+        }
+      }
+      continue;
+    }
+
+    auto& node = nodes[current];
+    uint32_t lanes = 0xFF;
+    if (frustum) {
+      float tFarthest = 0.f;
+      for (uint32_t mask = rays; mask != 0; mask &= mask - 1)
+        tFarthest = std::max(tFarthest, paths[indices[firstBit(mask)]].t);
+      lanes = frustumLanes(node, originMin, originMax, inverseMin, inverseMax, 0.001f, tFarthest);
+      // the whole packet misses every child, rays aren't tested one by one
+      if (lanes == 0) continue;
+    }
+
+    uint32_t childRays[8] = {};
+    float nearest[8];
+    std::fill(nearest, nearest + 8, std::numeric_limits<float>::infinity());
+    for (; rays != 0; rays &= rays - 1) {
+      int ray = firstBit(rays);
+      auto& path = paths[indices[ray]];
+      alignas(32) float tEntry[8];
+      uint32_t mask = _kernels.hitBoxes(path.ray, path.inverseDirection, node, 0.001f, path.t, tEntry) & lanes;
+      for (; mask != 0; mask &= mask - 1) {
+        int lane = firstBit(mask);
+        childRays[lane] |= 1u << ray;
+        nearest[lane] = std::min(nearest[lane], tEntry[lane]);
+      }
+    }
+    // far children are pushed first, so the near ones are visited first and shorten the range for the rest
+    int order[8];
+    int count = sortChildren(childRays, nearest, order);
+    for (int i = count - 1; i >= 0; i--) stack[size++] = {node.child[order[i]], childRays[order[i]]};
+  }
+}
+
+void PathTracer::_traverseStream(std::vector<PathState>& paths,
+                                 int node,
+                                 int begin,
+                                 int end,
+                                 std::vector<int>& rays,
+                                 std::vector<uint32_t>& masks) {
+  if (node < 0) {
+    auto& leaf = _wideBVH->getLeaves()[~node];
+    for (int i = begin; i < end; i++) {
+      auto& path = paths[rays[i]];
+      float t;
+      int lane = _kernels.hitSpheres(path.ray, leaf, 0.001f, path.t, t);
+      if (lane >= 0) {
+        path.t = t;
+        path.sphere = leaf.sphere[lane];
+      }
+    }
+    return;
+  }
+
+  auto& wideNode = _wideBVH->getNodes()[node];
+  uint32_t childRays[8] = {};
+  float nearest[8];
+  std::fill(nearest, nearest + 8, std::numeric_limits<float>::infinity());
+  for (int i = begin; i < end; i++) {
+    auto& path = paths[rays[i]];
+    alignas(32) float tEntry[8];
+    masks[i] = _kernels.hitBoxes(path.ray, path.inverseDirection, wideNode, 0.001f, path.t, tEntry);
+    for (uint32_t mask = masks[i]; mask != 0; mask &= mask - 1) {
+      int lane = firstBit(mask);
+      childRays[lane]++;
+      nearest[lane] = std::min(nearest[lane], tEntry[lane]);
+    }
+  }
+
+  // children are visited near to far, rays hitting a child are filtered to the end of the buffer and the range
+  // is dropped after the child is done
+  int order[8];
+  int count = sortChildren(childRays, nearest, order);
+  for (int i = count - 1; i >= 0; i--) {
+    int lane = order[i];
+    int childBegin = rays.size();
+    for (int j = begin; j < end; j++) {
+      if (masks[j] & (1u << lane)) {
+        rays.push_back(rays[j]);
+        masks.push_back(0);
+      }
+    }
+    _traverseStream(paths, wideNode.child[lane], childBegin, rays.size(), rays, masks);
+    rays.resize(childBegin);
+    masks.resize(childBegin);
+  }
+}
+
+void PathTracer::_intersect(std::vector<PathState>& paths,
+                            std::vector<int>& active,
+                            TraversalMode mode,
+                            RayCounter& counter) {
+  counter.rays += active.size();
+  counter.traversals[static_cast<int>(mode) - 1] += active.size();
+  for (int index : active) {
+    auto& path = paths[index];
+    path.inverseDirection = 1.f / path.ray.direction;
+    path.t = 100000.f;
+    path.sphere = -1;
+  }
+
+  if (mode == TraversalMode::PACKET) {
+    for (int i = 0; i < active.size(); i += packetSize)
+      _intersectPacket(paths, active.data() + i, std::min(packetSize, static_cast<int>(active.size()) - i));
+  } else if (mode == TraversalMode::STREAM) {
+    std::vector<int> rays(active);
+    std::vector<uint32_t> masks(active.size());
+    rays.reserve(active.size() * 8);
+    masks.reserve(active.size() * 8);
+    _traverseStream(paths, _wideBVH->getRoot(), 0, active.size(), rays, masks);
+  } else {
+    for (int index : active) {
+      auto& path = paths[index];
+      HitRecord hitRecord;
+      if (_hitWorld(path.ray, 0.001f, path.t, hitRecord)) {
+        path.t = hitRecord.t;
+        path.sphere = hitRecord.sphere;
+      }
+    }
+  }
+}
+
+bool PathTracer::_shade(PathState& path, uint64_t& rays) {
+  auto& spheres = _scene->getSpheres();
+  if (path.sphere < 0) {
+    // ray escapes to the sky
+    float t = 0.5f * (path.ray.direction.y + 1);
+    glm::vec3 background = (1.f - t) * glm::vec3(1.f, 1.f, 1.f) + t * glm::vec3(0.5f, 0.7f, 1.f);
+    if (path.depth == _maxDepth) {
+      path.primaryAlbedo = background;
+      path.primaryNormal = glm::vec3(0.f);
+      path.primaryDepth = farDepth;
+    }
+    path.radiance += path.throughput * background;
+    return false;
+  }
+
+  HitRecord hitRecord;
+  fillHitRecord(path.ray, spheres.spheres[path.sphere], path.sphere, path.t, hitRecord);
+  if (path.depth == _maxDepth) {
+    path.primaryAlbedo = hitRecord.material.attenuation;
+    path.primaryNormal = hitRecord.normal;
+    path.primaryDepth = hitRecord.t;
+  }
+  if (hitRecord.material.type == MATERIAL_EMISSIVE) {
+    // lights emit only outside and don't reflect
+    if (hitRecord.frontFace) {
+      float weight = 1.f;
+      if (_useNEE && path.bsdfPdf > 0.f)
+        weight = powerHeuristic(path.bsdfPdf,
+                                _lightPdf(path.previousPoint, path.previousNormal, spheres.spheres[hitRecord.sphere]));
+      path.radiance += path.throughput * hitRecord.material.attenuation * weight;
+    }
+    return false;
+  }
+
+  bool success = false;
+  // dimension set 0 is pixel jitter, every bounce takes next one, light sampling goes after the bounce ones
+  glm::vec4 u = _sobolSample(path.sample, 1 + _maxDepth - path.depth);
+  path.bsdfPdf = 0.f;
+  if (hitRecord.material.type == MATERIAL_DIFFUSE) {
+    if (_useNEE) {
+      glm::vec3 uLight = glm::vec3(_sobolSample(path.sample, 1 + 2 * _maxDepth - path.depth));
+      path.radiance += path.throughput * _sampleLight(hitRecord, uLight, rays);
+    }
+    success = diffuseMaterial(hitRecord, u, path.ray, path.throughput);
+    path.bsdfPdf = std::max(glm::dot(path.ray.direction, hitRecord.normal), 0.f) / glm::pi<float>();
+    path.previousPoint = hitRecord.point;
+    path.previousNormal = hitRecord.normal;
+  }
+  if (hitRecord.material.type == MATERIAL_METAL) success = metalMaterial(hitRecord, u, path.ray, path.throughput);
+  if (hitRecord.material.type == MATERIAL_DIELECTRIC) success = dielectricMaterial(hitRecord, u, path.ray);
+
+  // path which runs out of depth is terminated without sky
+  path.depth -= 1;
+  return success && path.depth > 0;
+}
+
+void PathTracer::_renderTile(Tile tile,
+                             UniformCamera& camera,
+                             std::tuple<int, int> extent,
+                             uint32_t frameIndex,
+                             int worker) {
+  auto [width, height] = extent;
+  int fullWidth = std::get<0>(_resolution);
+  float aspect = static_cast<float>(width) / height;
+  glm::vec4 rayOCamera = camera.camera * glm::vec4(0.f, 0.f, 0.f, 1.f);
+  // paths go block by block and inside a block sample by sample, so every packet of consecutive camera rays
+  // starts from neighbor pixels with the same sample index
+  std::vector<PathState> paths;
+  paths.reserve(tile.width * tile.height * _aaSamples);
+  for (int blockY = tile.y; blockY < tile.y + tile.height; blockY += packetSide) {
+    for (int blockX = tile.x; blockX < tile.x + tile.width; blockX += packetSide) {
+      for (int i = 0; i < _aaSamples; i++) {
+        for (int y = blockY; y < std::min(blockY + packetSide, tile.y + tile.height); y++) {
+          for (int x = blockX; x < std::min(blockX + packetSide, tile.x + tile.width); x++) {
+            PathState path;
+            path.sample.pixelSeed = initRandomSeed(x, y);
+            path.sample.sampleIndex = frameIndex * _aaSamples + i;
+            glm::vec2 aa = glm::vec2(_sobolSample(path.sample, 0));
+            glm::vec2 uv = (glm::vec2(x, y) + aa) / glm::vec2(width, height);
+            glm::vec3 rayE = glm::vec3((uv * 2.f - 1.f) * glm::vec2(aspect, 1.f) * camera.fov, -1.f);
+            glm::vec4 rayECamera = camera.camera * glm::vec4(rayE, 1.f);
+            path.ray = Ray{camera.origin, glm::normalize(glm::vec3(rayECamera) - glm::vec3(rayOCamera))};
+            path.radiance = glm::vec3(0.f);
+            path.throughput = glm::vec3(1.f);
+            path.bsdfPdf = 0.f;
+            path.depth = _maxDepth;
+            path.primaryAlbedo = path.primaryNormal = glm::vec3(0.f);
+            path.primaryDepth = 0.f;
+            path.pixel = (y - tile.y) * tile.width + (x - tile.x);
+            paths.push_back(path);
+          }
+        }
+      }
+    }
+  }
+
+  auto& counter = _rays[worker];
+  std::vector<int> active;
+  if (_maxDepth > 0) {
+    active.resize(paths.size());
+    std::iota(active.begin(), active.end(), 0);
+  }
+  while (active.empty() == false) {
+    _intersect(paths, active, _chooseTraversal(paths, active), counter);
+    // terminated paths are removed keeping the order, so packets of the next bounce still start from neighbors
+    int alive = 0;
+    for (int index : active) {
+      if (_shade(paths[index], counter.rays)) active[alive++] = index;
+    }
+    active.resize(alive);
+  }
+
+  // paths of a pixel are summed in sample order
+  std::vector<glm::vec3> pixels(tile.width * tile.height, glm::vec3(0.f));
+  std::vector<glm::vec3> albedo(pixels.size(), glm::vec3(0.f)), normal(pixels.size(), glm::vec3(0.f));
+  std::vector<float> depth(pixels.size(), 0.f);
+  for (auto& path : paths) {
+    pixels[path.pixel] += path.radiance;
+    albedo[path.pixel] += path.primaryAlbedo;
+    normal[path.pixel] += path.primaryNormal;
+    depth[path.pixel] += path.primaryDepth;
+  }
+  float samples = static_cast<float>(_aaSamples);
+  for (int y = tile.y; y < tile.y + tile.height; y++) {
+    for (int x = tile.x; x < tile.x + tile.width; x++) {
+      int pixel = (y - tile.y) * tile.width + (x - tile.x);
+      int index = (height - 1 - y) * fullWidth + x;
+      _result[index] = glm::vec4(pixels[pixel] / samples, 1.f);
+      _albedo[index] = glm::vec4(albedo[pixel] / samples, 0.f);
+      // normals of pixel footprint can point to different directions on edges
+      float normalLength = glm::length(normal[pixel]);
+      if (normalLength > 0.f) normal[pixel] /= normalLength;
+      _normalDepth[index] = glm::vec4(normal[pixel], depth[pixel] / samples);
+    }
+  }
+}
+
+void PathTracer::render(UniformCamera camera, std::tuple<int, int> extent, uint32_t frameIndex, int firstRow) {
+  for (auto& counter : _rays) counter = RayCounter{};
+  auto start = std::chrono::steady_clock::now();
+  auto [width, height] = extent;
+  auto tiles = TileScheduler::split({width, std::max(height - firstRow, 0)}, _tileSize);
+  for (auto& tile : tiles) tile.y += firstRow;
+  _scheduler->run(tiles, [&](int worker, Tile tile) { _renderTile(tile, camera, extent, frameIndex, worker); });
+  _time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  uint64_t rays = 0;
+  for (auto& counter : _rays) rays += counter.rays;
+  _mrays = rays / std::max(_time * 1000.f, 1e-3f);
+}
+
+std::vector<glm::vec4>& PathTracer::getResult() { return _result; }
+
+std::vector<glm::vec4>& PathTracer::getAlbedo() { return _albedo; }
+
+std::vector<glm::vec4>& PathTracer::getNormalDepth() { return _normalDepth; }
+
+float PathTracer::getTime() { return _time; }
+
+float PathTracer::getMraysPerSecond() { return _mrays; }
+
+std::array<float, 3> PathTracer::getTraversalShares() {
+  std::array<uint64_t, 3> traversals = {};
+  for (auto& counter : _rays) {
+    for (int i = 0; i < 3; i++) traversals[i] += counter.traversals[i];
+  }
+  float total = std::max<uint64_t>(1, traversals[0] + traversals[1] + traversals[2]);
+  return {traversals[0] / total, traversals[1] / total, traversals[2] / total};
+}
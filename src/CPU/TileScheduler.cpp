@@ -0,0 +1,92 @@
+#include "TileScheduler.h"
+#include <algorithm>
+
+TileScheduler::TileScheduler(int threads) {
+  if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 0; i < threads; i++) _queues.push_back(std::make_unique<WorkQueue>());
+  for (int i = 0; i < threads; i++) _threads.emplace_back(&TileScheduler::_work, this, i);
+}
+
+std::vector<Tile> TileScheduler::split(std::tuple<int, int> extent, int tileSize) {
+  auto [width, height] = extent;
+  std::vector<Tile> tiles;
+  for (int y = 0; y < height; y += tileSize) {
+    for (int x = 0; x < width; x += tileSize) {
+      tiles.push_back({x, y, std::min(tileSize, width - x), std::min(tileSize, height - y)});
+    }
+  }
+  return tiles;
+}
+
+bool TileScheduler::_pop(int worker, Tile& tile) {
+  {
+    auto& own = *_queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.tiles.empty() == false) {
+      tile = own.tiles.front();
+      own.tiles.pop_front();
+      return true;
+    }
+  }
+  // victims are visited starting from the neighbor, so thieves spread over different queues
+  for (int i = 1; i < _queues.size(); i++) {
+    auto& victim = *_queues[(worker + i) % _queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tiles.empty() == false) {
+      tile = victim.tiles.back();
+      victim.tiles.pop_back();
+      _steals++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TileScheduler::_work(int worker) {
+  uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _start.wait(lock, [&] { return _stop || _generation != generation; });
+      if (_stop) return;
+      generation = _generation;
+    }
+
+    Tile tile;
+    while (_pop(worker, tile)) _task(worker, tile);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_active == 0) _finish.notify_one();
+  }
+}
+
+void TileScheduler::run(std::vector<Tile> tiles, std::function<void(int worker, Tile tile)> task) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  int workers = _queues.size();
+  // contiguous ranges keep neighbor tiles, which touch the same BVH nodes, on one core
+  for (int i = 0; i < workers; i++) {
+    std::lock_guard<std::mutex> lockQueue(_queues[i]->mutex);
+    auto begin = tiles.begin() + tiles.size() * i / workers;
+    auto end = tiles.begin() + tiles.size() * (i + 1) / workers;
+    _queues[i]->tiles.assign(begin, end);
+  }
+  _task = task;
+  _active = workers;
+  _steals = 0;
+  _generation++;
+  _start.notify_all();
+  _finish.wait(lock, [&] { return _active == 0; });
+}
+
+int TileScheduler::getThreads() { return _threads.size(); }
+
+uint64_t TileScheduler::getSteals() { return _steals; }
+
+TileScheduler::~TileScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _start.notify_all();
+  for (auto& thread : _threads) thread.join();
+}
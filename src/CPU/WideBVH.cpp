@@ -0,0 +1,105 @@
+#include "WideBVH.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+// unused lanes: squared radius makes discriminant negative, point box far away has no volume to overlap
+constexpr float emptyRadius2 = -1e30f;
+constexpr float emptyBox = 1e30f;
+
+SphereLeaf WideBVH::_createLeaf(UniformSpheres& spheres, std::vector<int>& indices) {
+  SphereLeaf leaf;
+  for (int i = 0; i < 8; i++) {
+    leaf.centerX[i] = leaf.centerY[i] = leaf.centerZ[i] = 0.f;
+    leaf.radius2[i] = emptyRadius2;
+    leaf.sphere[i] = -1;
+    if (i < indices.size()) {
+      auto& sphere = spheres.spheres[indices[i]];
+      leaf.centerX[i] = sphere.center.x;
+      leaf.centerY[i] = sphere.center.y;
+      leaf.centerZ[i] = sphere.center.z;
+      leaf.radius2[i] = sphere.radius * sphere.radius;
+      leaf.sphere[i] = indices[i];
+    }
+  }
+  return leaf;
+}
+
+// children are made by repeatedly splitting the largest group by the median of centers along its longest axis,
+// until there are 8 groups or every group fits a leaf
+int WideBVH::_build(UniformSpheres& spheres, std::vector<int> indices, glm::vec3& min, glm::vec3& max, int level) {
+  min = glm::vec3(std::numeric_limits<float>::max());
+  max = glm::vec3(-std::numeric_limits<float>::max());
+  for (auto index : indices) {
+    min = glm::min(min, spheres.spheres[index].center - spheres.spheres[index].radius);
+    max = glm::max(max, spheres.spheres[index].center + spheres.spheres[index].radius);
+  }
+  if (indices.size() <= 8) {
+    _leaves.push_back(_createLeaf(spheres, indices));
+    return ~static_cast<int>(_leaves.size() - 1);
+  }
+
+  std::vector<std::vector<int>> groups = {indices};
+  while (groups.size() < 8) {
+    auto largest = std::max_element(groups.begin(), groups.end(),
+                                    [](auto& left, auto& right) { return left.size() < right.size(); });
+    if (largest->size() <= 8) break;
+    auto group = *largest;
+    glm::vec3 minCenter = spheres.spheres[group[0]].center, maxCenter = minCenter;
+    for (auto index : group) {
+      minCenter = glm::min(minCenter, spheres.spheres[index].center);
+      maxCenter = glm::max(maxCenter, spheres.spheres[index].center);
+    }
+    glm::vec3 size = maxCenter - minCenter;
+    int axis = 0;
+    if (size.y > size[axis]) axis = 1;
+    if (size.z > size[axis]) axis = 2;
+    std::sort(group.begin(), group.end(), [&](int left, int right) {
+      return spheres.spheres[left].center[axis] < spheres.spheres[right].center[axis];
+    });
+    *largest = std::vector<int>(group.begin() + group.size() / 2, group.end());
+    groups.push_back(std::vector<int>(group.begin(), group.begin() + group.size() / 2));
+  }
+
+  _depth = std::max(_depth, level + 1);
+  int index = _nodes.size();
+  _nodes.push_back(WideNode{});
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 childMin(emptyBox), childMax(emptyBox);
+    int child = 0;
+    if (i < groups.size()) child = _build(spheres, groups[i], childMin, childMax, level + 1);
+    // vector may be reallocated by recursion
+    auto& node = _nodes[index];
+    node.child[i] = child;
+    node.minX[i] = childMin.x;
+    node.minY[i] = childMin.y;
+    node.minZ[i] = childMin.z;
+    node.maxX[i] = childMax.x;
+    node.maxY[i] = childMax.y;
+    node.maxZ[i] = childMax.z;
+  }
+  return index;
+}
+
+WideBVH::WideBVH(std::shared_ptr<Scene> scene) {
+  auto& spheres = scene->getSpheres();
+  for (int first = 0; first < spheres.number; first += 8) {
+    std::vector<int> indices;
+    for (int i = first; i < std::min(first + 8, spheres.number); i++) indices.push_back(i);
+    _sphereGroups.push_back(_createLeaf(spheres, indices));
+  }
+
+  std::vector<int> indices(spheres.number);
+  std::iota(indices.begin(), indices.end(), 0);
+  glm::vec3 min, max;
+  _root = _build(spheres, indices, min, max, 0);
+  if (7 * _depth + 1 > stackSize) throw std::runtime_error("wide BVH is too deep for traversal stack!");
+}
+
+std::vector<WideNode>& WideBVH::getNodes() { return _nodes; }
+
+std::vector<SphereLeaf>& WideBVH::getLeaves() { return _leaves; }
+
+std::vector<SphereLeaf>& WideBVH::getSphereGroups() { return _sphereGroups; }
+
+int WideBVH::getRoot() { return _root; }
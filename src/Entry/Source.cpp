@@ -24,22 +24,74 @@
 
 #include "OffscreenPart.h"
 #include "ComputePart.h"
+#include "ReSTIRPart.h"
+#include "TemporalPart.h"
+#include "DenoisePart.h"
+#include "PostprocessPart.h"
 #include "ScreenPart.h"
+#include "Scene.h"
+#include "PathTracer.h"
+#include "HybridPart.h"
+#include "CapturePart.h"
+#include "KernelBenchmark.h"
+#include "ImageEncoder.h"
+#include "Profiler.h"
+#include <glm/gtc/packing.hpp>
+#include <random>
+#include <map>
 
 float fps = 0;
 uint64_t currentFrame = 0;
+bool autotune = false;
+// CPU backend renders reference image without Vulkan
+bool cpu = false;
+int cpuFrames = 1;
+bool benchmarkKernels = false;
+// empty means the widest one supported by CPU
+std::string cpuInstructionSet;
+// empty means packets or stream picked every bounce
+std::string cpuTraversal;
+bool benchmarkTraversal = false;
+// name substring or index of Vulkan device, empty means the best ranked one
+std::string deviceName;
+bool listDevices = false;
+// only Device and ComputePart are created, result is read back and written to file
+bool headless = false;
+// 0 keeps default samples per frame of ComputePart
+int samples = 0;
+// format is picked by extension, empty means cpu.pfm or gpu.pfm
+std::string output;
+// captures every frame from start, frames are numbered before extension
+std::string capturePath;
+// GPU times of the frame regions are written to this CSV from start
+std::string profilePath;
+// ray tracing passes go to compute queue of family without graphics if device has one
+bool asyncCompute = true;
+// the same seed gives the same scene to both backends
+uint32_t seed = std::random_device{}();
+bool seedRequested = false;
 
 std::shared_ptr<Window> window;
 std::shared_ptr<Instance> instance;
 std::shared_ptr<Device> device;
 std::shared_ptr<CommandBuffer> commandBuffer;
 std::shared_ptr<CommandPool> commandPool;
+// ray tracing dispatch is recorded to tracingCommandBuffer, passes from merge of CPU rows to post processing are
+// recorded here, both are submitted to compute queue; screen and GUI are recorded to commandBuffer and submitted to
+// graphic queue
+std::shared_ptr<CommandBuffer> tracingCommandBuffer;
+std::shared_ptr<CommandBuffer> computeCommandBuffer;
+std::shared_ptr<CommandPool> computeCommandPool;
 std::shared_ptr<Queue> queue;
 std::shared_ptr<Surface> surface;
 std::shared_ptr<Settings> settings;
+std::shared_ptr<Scene> scene;
 std::array<VkClearValue, 2> clearValues{};
 
 std::vector<std::shared_ptr<Semaphore>> imageAvailableSemaphores, renderFinishedSemaphores;
+// compute submit signals graphic one, copy of capture signals the next compute submit of the same frame slot
+std::vector<std::shared_ptr<Semaphore>> computeFinishedSemaphores, captureFinishedSemaphores;
+std::vector<bool> captureSubmitted;
 std::vector<std::shared_ptr<Fence>> inFlightFences;
 
 std::shared_ptr<SpriteManager> spriteManager;
@@ -49,26 +101,94 @@ std::shared_ptr<Model3D> model3D;
 
 std::shared_ptr<GUI> gui;
 std::shared_ptr<ComputePart> computePart;
+std::shared_ptr<HybridPart> hybridPart;
+std::shared_ptr<ReSTIRPart> restirPart;
+std::shared_ptr<TemporalPart> temporalPart;
+std::shared_ptr<DenoisePart> denoisePart;
+std::shared_ptr<PostprocessPart> postprocessPart;
 std::shared_ptr<ScreenPart> screenPart;
+std::shared_ptr<CapturePart> capturePart;
+std::shared_ptr<Profiler> profiler;
 
 void initializeCompute() {
-  computePart = std::make_shared<ComputePart>(device, queue, commandBuffer, commandPool, settings);
+  computePart = std::make_shared<ComputePart>(scene, device, queue, tracingCommandBuffer, commandPool, settings);
+  computePart->autotune("workgroup.txt", autotune);
+}
+
+void initializeReSTIR() {
+  restirPart = std::make_shared<ReSTIRPart>(computePart, device, queue, computeCommandBuffer, commandPool, settings);
+}
+
+void initializeHybrid() { hybridPart = std::make_shared<HybridPart>(scene, device, computeCommandBuffer, settings); }
+
+void initializeTemporal() {
+  temporalPart = std::make_shared<TemporalPart>(computePart->getResultTextures(), computePart->getNormalDepthTextures(),
+                                                device, queue, computeCommandBuffer, commandPool, settings);
+}
+
+void initializeDenoise() {
+  denoisePart = std::make_shared<DenoisePart>(temporalPart->getResultTextures(), computePart->getAlbedoTextures(),
+                                              computePart->getNormalDepthTextures(), device, queue,
+                                              computeCommandBuffer, commandPool, settings);
+}
+
+void initializePostprocess() {
+  postprocessPart = std::make_shared<PostprocessPart>(denoisePart->getResultTextures(), device, queue,
+                                                      computeCommandBuffer, commandPool, settings);
 }
 
 void initializeScreen() {
-  screenPart = std::make_shared<ScreenPart>(computePart->getResultTextures(), window, surface, device, queue,
+  screenPart = std::make_shared<ScreenPart>(postprocessPart->getResultTextures(), window, surface, device, queue,
                                             commandPool, commandBuffer, settings);
+  // SRGB swapchain encodes gamma on write, UNORM fallback gets encoded values from post processing
+  auto format = screenPart->getSwapchain()->getImageFormat();
+  postprocessPart->setEncodeGamma(format != VK_FORMAT_B8G8R8A8_SRGB && format != VK_FORMAT_R8G8B8A8_SRGB);
+}
+
+void initializeCapture() {
+  capturePart = std::make_shared<CapturePart>(device, queue, commandPool, settings);
+  // displayed image is captured, with UNORM swapchain it's gamma encoded by post processing
+  auto format = screenPart->getSwapchain()->getImageFormat();
+  capturePart->setDecodeGamma(format != VK_FORMAT_B8G8R8A8_SRGB && format != VK_FORMAT_R8G8B8A8_SRGB);
+  if (capturePath.empty() == false) {
+    capturePart->setPath(capturePath);
+    capturePart->setEnabled(true);
+  }
 }
 
 PFN_vkCmdBeginDebugUtilsLabelEXT CmdBeginDebugUtilsLabelEXT;
 PFN_vkCmdEndDebugUtilsLabelEXT CmdEndDebugUtilsLabelEXT;
 PFN_vkSetDebugUtilsObjectNameEXT SetDebugUtilsObjectNameEXT;
 
+void initializeProfiler() {
+  profiler = std::make_shared<Profiler>(device, settings);
+  if (profilePath.empty() == false) {
+    profiler->setPath(profilePath);
+    profiler->setEnabled(true);
+  }
+}
+
+// debug label for tools like RenderDoc and timestamps of the profiler around the same region, queue labels the queue
+// the command buffer is submitted to, the profiler sums regions per queue
+void beginRegion(VkCommandBuffer commandBuffer, const char* name, std::string queueName) {
+  VkDebugUtilsLabelEXT markerInfo = {};
+  markerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+  markerInfo.pLabelName = name;
+  CmdBeginDebugUtilsLabelEXT(commandBuffer, &markerInfo);
+  profiler->begin(commandBuffer, currentFrame, name, queueName);
+}
+
+void endRegion(VkCommandBuffer commandBuffer) {
+  profiler->end(commandBuffer, currentFrame);
+  CmdEndDebugUtilsLabelEXT(commandBuffer);
+}
+
 void initialize() {
   clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
   clearValues[1].depthStencil = {1.0f, 0};
 
   settings = std::make_shared<Settings>(std::tuple{800, 592}, 2);
+  scene = std::make_shared<Scene>(seed);
   window = std::make_shared<Window>(settings->getResolution());
   Input::initialize(window);
   instance = std::make_shared<Instance>("Vulkan", true, window);
@@ -80,18 +200,33 @@ void initialize() {
                                                                                        "vkSetDebugUtilsObjectNameEXT");
 
   surface = std::make_shared<Surface>(window, instance);
-  device = std::make_shared<Device>(surface, instance);
+  device = std::make_shared<Device>(surface, instance, deviceName);
   commandPool = std::make_shared<CommandPool>(device);
-  queue = std::make_shared<Queue>(device);
+  queue = std::make_shared<Queue>(device, asyncCompute);
+  std::cout << "compute queue family: " << queue->getComputeFamilyIndex()
+            << (queue->isAsyncCompute() ? " (async)" : " (graphic)") << std::endl;
   commandBuffer = std::make_shared<CommandBuffer>(settings->getMaxFramesInFlight(), commandPool, device);
+  computeCommandPool = std::make_shared<CommandPool>(device, queue->getComputeFamilyIndex());
+  tracingCommandBuffer = std::make_shared<CommandBuffer>(settings->getMaxFramesInFlight(), computeCommandPool, device);
+  computeCommandBuffer = std::make_shared<CommandBuffer>(settings->getMaxFramesInFlight(), computeCommandPool, device);
   for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
     imageAvailableSemaphores.push_back(std::make_shared<Semaphore>(device));
     renderFinishedSemaphores.push_back(std::make_shared<Semaphore>(device));
+    computeFinishedSemaphores.push_back(std::make_shared<Semaphore>(device));
+    captureFinishedSemaphores.push_back(std::make_shared<Semaphore>(device));
     inFlightFences.push_back(std::make_shared<Fence>(device));
   }
+  captureSubmitted.resize(settings->getMaxFramesInFlight(), false);
 
   initializeCompute();
+  initializeHybrid();
+  initializeReSTIR();
+  initializeTemporal();
+  initializeDenoise();
+  initializePostprocess();
   initializeScreen();
+  initializeCapture();
+  initializeProfiler();
 
   gui = std::make_shared<GUI>(settings->getResolution(), window, device);
   gui->initialize(screenPart->getRenderPass(), queue, commandPool);
@@ -118,34 +253,73 @@ void drawFrame() {
   auto result = vkWaitForFences(device->getLogicalDevice(), 1, &inFlightFences[currentFrame]->getFence(), VK_TRUE,
                                 UINT64_MAX);
   if (result != VK_SUCCESS) throw std::runtime_error("Can't wait for fence");
+  // the slot's previous frame is done, its timestamps are read without waiting
+  profiler->resolve(currentFrame);
 
-  uint32_t imageIndex;
-  // RETURNS ONLY INDEX, NOT IMAGE
-  result = vkAcquireNextImageKHR(device->getLogicalDevice(), screenPart->getSwapchain()->getSwapchain(), UINT64_MAX,
-                                 imageAvailableSemaphores[currentFrame]->getSemaphore(), VK_NULL_HANDLE, &imageIndex);
-
-  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-    // TODO: recreate swapchain
-    return;
-  } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-    throw std::runtime_error("failed to acquire swap chain image!");
-  }
-
+  // the fence is signaled by graphic submit of this frame slot even if swapchain image isn't acquired
   result = vkResetFences(device->getLogicalDevice(), 1, &inFlightFences[currentFrame]->getFence());
   if (result != VK_SUCCESS) throw std::runtime_error("Can't reset fence");
 
-  result = vkResetCommandBuffer(commandBuffer->getCommandBuffer()[currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
-  if (result != VK_SUCCESS) throw std::runtime_error("Can't reset cmd buffer");
-
   gui->addText("FPS", {20, 20}, {100, 60}, {std::to_string(fps)});
   gui->addCheckbox("Compute", {20, 80}, {100, 60}, computePart->getCheckboxes());
+  gui->addSlider("Compute", {20, 80}, {100, 60}, computePart->getSliders());
+  gui->addSlider("Compute", {20, 80}, {100, 60}, computePart->getSlidersFloat());
+  gui->addText("Compute", {20, 80}, {100, 60},
+               {"time: " + std::to_string(computePart->getTime()) + " ms",
+                "scale: " + std::to_string(computePart->getScale()),
+                "cache occupancy: " + std::to_string(computePart->getCacheOccupancy()),
+                "guide occupancy: " + std::to_string(computePart->getGuideOccupancy()),
+                std::string("queue: ") + (queue->isAsyncCompute() ? "async compute" : "graphic")});
+  gui->addCheckbox("Hybrid", {20, 560}, {100, 60}, hybridPart->getCheckboxes());
+  gui->addText("Hybrid", {20, 560}, {100, 60},
+               {"GPU share: " + std::to_string(hybridPart->getGPUShare()),
+                "CPU time: " + std::to_string(hybridPart->getCPUTime()) + " ms",
+                "CPU threads: " + std::to_string(hybridPart->getThreads())});
+  gui->addCheckbox("Capture", {140, 20}, {100, 60}, capturePart->getCheckboxes());
+  gui->addText("Capture", {140, 20}, {100, 60},
+               {"captured: " + std::to_string(capturePart->getCaptured()),
+                "dropped: " + std::to_string(capturePart->getDropped())});
+  gui->addCheckbox("Profiler", {140, 100}, {100, 60}, profiler->getCheckboxes());
+  gui->addText("Profiler", {140, 100}, {100, 60}, profiler->getStatistics());
+  gui->addCheckbox("Screen", {20, 320}, {100, 60}, screenPart->getCheckboxes());
+  gui->addCheckbox("ReSTIR", {20, 400}, {100, 60}, restirPart->getCheckboxes());
+  gui->addSlider("ReSTIR", {20, 400}, {100, 60}, restirPart->getSliders());
+  gui->addSlider("ReSTIR", {20, 400}, {100, 60}, restirPart->getSlidersFloat());
+  gui->addText("ReSTIR", {20, 400}, {100, 60},
+               {"time: " + std::to_string(restirPart->getTime()) + " ms",
+                "candidates: " + std::to_string(restirPart->getCandidates()),
+                "visible: " + std::to_string(restirPart->getVisible())});
+  gui->addCheckbox("Temporal", {20, 240}, {100, 60}, temporalPart->getCheckboxes());
+  gui->addSlider("Temporal", {20, 240}, {100, 60}, temporalPart->getSliders());
+  gui->addSlider("Temporal", {20, 240}, {100, 60}, temporalPart->getSlidersFloat());
+  gui->addCheckbox("Denoise", {20, 160}, {100, 60}, denoisePart->getCheckboxes());
+  gui->addSlider("Denoise", {20, 160}, {100, 60}, denoisePart->getSliders());
+  gui->addSlider("Denoise", {20, 160}, {100, 60}, denoisePart->getSlidersFloat());
+  gui->addText("Denoise", {20, 160}, {100, 60}, {"time: " + std::to_string(denoisePart->getTime()) + " ms"});
+  gui->addCheckbox("Postprocess", {20, 480}, {100, 60}, postprocessPart->getCheckboxes());
+  gui->addSlider("Postprocess", {20, 480}, {100, 60}, postprocessPart->getSliders());
+  gui->addSlider("Postprocess", {20, 480}, {100, 60}, postprocessPart->getSlidersFloat());
+  std::vector<std::string> postprocessTimes;
+  for (auto& [name, time] : postprocessPart->getTimes())
+    postprocessTimes.push_back(name + " time: " + std::to_string(time) + " ms");
+  gui->addText("Postprocess", {20, 480}, {100, 60}, postprocessTimes);
   gui->updateBuffers(currentFrame);
 
+  /////////////////////////////////////////////////////////////////////////////////////////
+  // compute queue: ray tracing to post processing
+  /////////////////////////////////////////////////////////////////////////////////////////
+  // it's submitted before swapchain image is acquired, so it doesn't wait for the previous frame to be presented and
+  // runs next to its screen pass, GUI and present; everything written here is per frame slot, the previous frame
+  // uses the other slot
+  auto tracingCommand = tracingCommandBuffer->getCommandBuffer()[currentFrame];
+  result = vkResetCommandBuffer(tracingCommand, /*VkCommandBufferResetFlagBits*/ 0);
+  if (result != VK_SUCCESS) throw std::runtime_error("Can't reset cmd buffer");
+
   // record command buffer
   VkCommandBufferBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-  if (vkBeginCommandBuffer(commandBuffer->getCommandBuffer()[currentFrame], &beginInfo) != VK_SUCCESS) {
+  if (vkBeginCommandBuffer(tracingCommand, &beginInfo) != VK_SUCCESS) {
     throw std::runtime_error("failed to begin recording command buffer!");
   }
 
@@ -154,90 +328,235 @@ void drawFrame() {
       .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
       .pNext = NULL,
       .objectType = VK_OBJECT_TYPE_COMMAND_BUFFER,
-      .objectHandle = (uint64_t)commandBuffer->getCommandBuffer()[currentFrame],
+      .objectHandle = (uint64_t)tracingCommand,
       .pObjectName = "Raytracing command buffer",
   };
   SetDebugUtilsObjectNameEXT(device->getLogicalDevice(), &cmdBufInfo);
+  // the tracing submit goes first, the rest of compute and graphic ones follow it, so all get queries reset here
+  profiler->reset(tracingCommand, currentFrame);
+  // without async compute both command buffers go to the same queue and run one after another
+  std::string computeQueue = queue->isAsyncCompute() ? "compute" : "graphic";
 
-  VkDebugUtilsLabelEXT markerInfo = {};
-  markerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
-  markerInfo.pLabelName = "Raytraycing compute";
-  CmdBeginDebugUtilsLabelEXT(commandBuffer->getCommandBuffer()[currentFrame], &markerInfo);
+  beginRegion(tracingCommand, "Raytraycing compute", computeQueue);
 
-  /////////////////////////////////////////////////////////////////////////////////////////
-  // compute
-  /////////////////////////////////////////////////////////////////////////////////////////
-  vkCmdBindPipeline(commandBuffer->getCommandBuffer()[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE,
-                    computePart->getPipeline()->getPipeline());
+  // ray tracer leaves direct light of primary hits to ReSTIR
+  computePart->setReSTIR(restirPart->isEnabled());
+  computePart->setGPUShare(hybridPart->getGPUShare());
   computePart->draw(currentFrame);
+  // in hybrid mode CPU traces the rest of rows meanwhile
+  hybridPart->draw(currentFrame, computePart);
 
-  CmdEndDebugUtilsLabelEXT(commandBuffer->getCommandBuffer()[currentFrame]);
+  endRegion(tracingCommand);
 
-  markerInfo = {};
-  markerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
-  markerInfo.pLabelName = "Compute-Render sync";
-  CmdBeginDebugUtilsLabelEXT(commandBuffer->getCommandBuffer()[currentFrame], &markerInfo);
+  if (vkEndCommandBuffer(tracingCommand) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record command buffer!");
+  }
+
+  // capture of the previous frame in this slot may still copy the result on graphic queue
+  std::vector<VkSemaphore> computeWaitSemaphores;
+  std::vector<VkPipelineStageFlags> computeWaitStages;
+  if (captureSubmitted[currentFrame]) {
+    computeWaitSemaphores.push_back(captureFinishedSemaphores[currentFrame]->getSemaphore());
+    computeWaitStages.push_back(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    captureSubmitted[currentFrame] = false;
+  }
+  // dispatch is submitted alone, so it runs while CPU traces its rows; the rest of compute waits for CPU on host
+  // and is submitted after, GPU never waits for host work inside of a submitted command buffer
+  VkSubmitInfo tracingSubmitInfo{};
+  tracingSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  tracingSubmitInfo.waitSemaphoreCount = computeWaitSemaphores.size();
+  tracingSubmitInfo.pWaitSemaphores = computeWaitSemaphores.data();
+  tracingSubmitInfo.pWaitDstStageMask = computeWaitStages.data();
+  tracingSubmitInfo.commandBufferCount = 1;
+  tracingSubmitInfo.pCommandBuffers = &tracingCommand;
+  result = vkQueueSubmit(queue->getComputeQueue(), 1, &tracingSubmitInfo, VK_NULL_HANDLE);
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit ray tracing command buffer!");
+  }
+
+  auto computeCommand = computeCommandBuffer->getCommandBuffer()[currentFrame];
+  result = vkResetCommandBuffer(computeCommand, /*VkCommandBufferResetFlagBits*/ 0);
+  if (result != VK_SUCCESS) throw std::runtime_error("Can't reset cmd buffer");
+  if (vkBeginCommandBuffer(computeCommand, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording command buffer!");
+  }
+  cmdBufInfo.objectHandle = (uint64_t)computeCommand;
+  cmdBufInfo.pObjectName = "Compute command buffer";
+  SetDebugUtilsObjectNameEXT(device->getLogicalDevice(), &cmdBufInfo);
+
+  beginRegion(computeCommand, "Hybrid merge", computeQueue);
+
+  // waits for CPU rows, they are copied in before the next passes
+  hybridPart->merge(currentFrame, computePart);
+
+  endRegion(computeCommand);
+
+  beginRegion(computeCommand, "ReSTIR", computeQueue);
+
+  restirPart->draw(currentFrame, computePart->getCamera(), computePart->getExtent());
+
+  endRegion(computeCommand);
+
+  beginRegion(computeCommand, "Temporal accumulation", computeQueue);
+
+  temporalPart->draw(currentFrame, computePart->getCamera(), computePart->getExtent());
+
+  endRegion(computeCommand);
+
+  beginRegion(computeCommand, "Denoise", computeQueue);
+
+  denoisePart->draw(currentFrame, computePart->getExtent());
+
+  endRegion(computeCommand);
+
+  beginRegion(computeCommand, "Postprocess", computeQueue);
+
+  postprocessPart->draw(currentFrame, computePart->getExtent());
+
+  endRegion(computeCommand);
+
+  beginRegion(computeCommand, "Compute-Render sync", computeQueue);
 
   /////////////////////////////////////////////////////////////////////////////////////////
   // compute to graphic barrier
   /////////////////////////////////////////////////////////////////////////////////////////
   // Image memory barrier to make sure that compute shader writes are finished before sampling from the texture
+  // or blitting it to the swapchain image
+  bool directPresent = screenPart->isDirectPresent();
+  bool asyncCompute = queue->isAsyncCompute();
   VkImageMemoryBarrier imageMemoryBarrier = {};
   imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
   // We won't be changing the layout of the image
   imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
   imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-  imageMemoryBarrier.image = computePart->getResultTextures()[currentFrame]->getImageView()->getImage()->getImage();
+  imageMemoryBarrier.image = postprocessPart->getResultTextures()[currentFrame]->getImageView()->getImage()->getImage();
   imageMemoryBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
   imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  imageMemoryBarrier.dstAccessMask = directPresent ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_SHADER_READ_BIT;
   imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
   imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  vkCmdPipelineBarrier(commandBuffer->getCommandBuffer()[currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+  if (asyncCompute) {
+    // release half of ownership transfer to graphic queue, the writes are made visible by the acquire half there
+    imageMemoryBarrier.dstAccessMask = 0;
+    imageMemoryBarrier.srcQueueFamilyIndex = queue->getComputeFamilyIndex();
+    imageMemoryBarrier.dstQueueFamilyIndex = queue->getGraphicFamilyIndex();
+  }
+  VkPipelineStageFlags dstStage = directPresent ? VK_PIPELINE_STAGE_TRANSFER_BIT
+                                                : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  vkCmdPipelineBarrier(computeCommand, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       asyncCompute ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : dstStage, 0, 0, nullptr, 0, nullptr, 1,
+                       &imageMemoryBarrier);
 
-  CmdEndDebugUtilsLabelEXT(commandBuffer->getCommandBuffer()[currentFrame]);
+  endRegion(computeCommand);
 
-  markerInfo = {};
-  markerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
-  markerInfo.pLabelName = "Render to screen";
-  CmdBeginDebugUtilsLabelEXT(commandBuffer->getCommandBuffer()[currentFrame], &markerInfo);
+  if (vkEndCommandBuffer(computeCommand) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record command buffer!");
+  }
+
+  VkSubmitInfo computeSubmitInfo{};
+  computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  computeSubmitInfo.commandBufferCount = 1;
+  computeSubmitInfo.pCommandBuffers = &computeCommand;
+  computeSubmitInfo.signalSemaphoreCount = 1;
+  computeSubmitInfo.pSignalSemaphores = &computeFinishedSemaphores[currentFrame]->getSemaphore();
+  // frame's fence is signaled by graphic submit, which waits for this one
+  result = vkQueueSubmit(queue->getComputeQueue(), 1, &computeSubmitInfo, VK_NULL_HANDLE);
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit compute command buffer!");
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////
+  // graphic queue: screen and GUI
+  /////////////////////////////////////////////////////////////////////////////////////////
+  // the result is read by sprite draw or blit and by capture copy submitted after the frame
+  VkPipelineStageFlags resultStages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]->getSemaphore(),
+                                  computeFinishedSemaphores[currentFrame]->getSemaphore()};
+  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, resultStages};
+
+  uint32_t imageIndex;
+  // RETURNS ONLY INDEX, NOT IMAGE
+  result = vkAcquireNextImageKHR(device->getLogicalDevice(), screenPart->getSwapchain()->getSwapchain(), UINT64_MAX,
+                                 imageAvailableSemaphores[currentFrame]->getSemaphore(), VK_NULL_HANDLE, &imageIndex);
+
+  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    // TODO: recreate swapchain
+    // compute is submitted already, its semaphore has to be consumed and the fence signaled for the next wait
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &waitSemaphores[1];
+    submitInfo.pWaitDstStageMask = &waitStages[1];
+    result = vkQueueSubmit(queue->getGraphicQueue(), 1, &submitInfo, inFlightFences[currentFrame]->getFence());
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to submit draw command buffer!");
+    return;
+  } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+    throw std::runtime_error("failed to acquire swap chain image!");
+  }
+
+  auto graphicCommand = commandBuffer->getCommandBuffer()[currentFrame];
+  result = vkResetCommandBuffer(graphicCommand, /*VkCommandBufferResetFlagBits*/ 0);
+  if (result != VK_SUCCESS) throw std::runtime_error("Can't reset cmd buffer");
+
+  if (vkBeginCommandBuffer(graphicCommand, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording command buffer!");
+  }
+  cmdBufInfo.objectHandle = (uint64_t)graphicCommand;
+  cmdBufInfo.pObjectName = "Screen command buffer";
+  SetDebugUtilsObjectNameEXT(device->getLogicalDevice(), &cmdBufInfo);
+
+  if (asyncCompute) {
+    beginRegion(graphicCommand, "Compute-Render acquire", "graphic");
+
+    // acquire half of ownership transfer, stages match the semaphore wait, so the transfer happens after release
+    imageMemoryBarrier.srcAccessMask = 0;
+    imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(graphicCommand, resultStages, resultStages, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+    endRegion(graphicCommand);
+  }
+
+  beginRegion(graphicCommand, "Render to screen", "graphic");
   /////////////////////////////////////////////////////////////////////////////////////////
   // render to screen
   /////////////////////////////////////////////////////////////////////////////////////////
   {
+    // direct path copies the result to swapchain image and render pass only draws GUI on top of it
+    if (directPresent) screenPart->blit(currentFrame, imageIndex, computePart->getExtent());
+
     auto renderPassInfo = render(imageIndex, screenPart->getRenderPass(), screenPart->getFramebuffer(),
                                  screenPart->getSwapchain());
 
-    vkCmdBeginRenderPass(commandBuffer->getCommandBuffer()[currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-    for (auto sprite : screenPart->getSprites()) {
-      screenPart->getSpriteManager()->unregisterSprite(sprite);
+    vkCmdBeginRenderPass(graphicCommand, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    if (!directPresent) {
+      for (auto sprite : screenPart->getSprites()) {
+        screenPart->getSpriteManager()->unregisterSprite(sprite);
+      }
+      screenPart->setExtent(computePart->getExtent());
+      screenPart->getSpriteManager()->registerSprite(screenPart->getSprites()[currentFrame]);
+      screenPart->getSpriteManager()->draw(currentFrame);
     }
-    screenPart->getSpriteManager()->registerSprite(screenPart->getSprites()[currentFrame]);
-    screenPart->getSpriteManager()->draw(currentFrame);
-    gui->drawFrame(currentFrame, commandBuffer->getCommandBuffer()[currentFrame]);
+    gui->drawFrame(currentFrame, graphicCommand);
 
-    vkCmdEndRenderPass(commandBuffer->getCommandBuffer()[currentFrame]);
+    vkCmdEndRenderPass(graphicCommand);
   }
   ///////////////////////////////////////////////////////////////////////////////////////////
 
-  CmdEndDebugUtilsLabelEXT(commandBuffer->getCommandBuffer()[currentFrame]);
+  endRegion(graphicCommand);
 
-  if (vkEndCommandBuffer(commandBuffer->getCommandBuffer()[currentFrame]) != VK_SUCCESS) {
+  if (vkEndCommandBuffer(graphicCommand) != VK_SUCCESS) {
     throw std::runtime_error("failed to record command buffer!");
   }
   //
   VkSubmitInfo submitInfo{};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]->getSemaphore()};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  submitInfo.waitSemaphoreCount = 2;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
 
   submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = &commandBuffer->getCommandBuffer()[currentFrame];
+  submitInfo.pCommandBuffers = &graphicCommand;
 
   VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]->getSemaphore()};
   submitInfo.signalSemaphoreCount = 1;
@@ -247,6 +566,9 @@ void drawFrame() {
   if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
+  captureSubmitted[currentFrame] = capturePart->capture(postprocessPart->getResultTextures()[currentFrame],
+                                                        computePart->getExtent(),
+                                                        captureFinishedSemaphores[currentFrame]->getSemaphore());
 
   VkPresentInfoKHR presentInfo{};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -289,10 +611,174 @@ void mainLoop() {
   }
 
   vkDeviceWaitIdle(device->getLogicalDevice());
+  capturePart->flush();
+}
+
+// frames are averaged, every frame takes next samples of the sequence like temporal accumulation on GPU
+void renderCPU() {
+  settings = std::make_shared<Settings>(std::tuple{800, 592}, 2);
+  scene = std::make_shared<Scene>(seed);
+  auto scheduler = std::make_shared<TileScheduler>();
+  auto pathTracer = std::make_shared<PathTracer>(scene, scheduler, settings->getResolution());
+  // start pose of ComputePart camera
+  auto camera = createCamera(glm::vec3(0, 2, 3), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), 90.f);
+  std::map<std::string, InstructionSet> instructionSets = {
+      {"scalar", InstructionSet::SCALAR}, {"sse4", InstructionSet::SSE4}, {"avx2", InstructionSet::AVX2}};
+  if (instructionSets.contains(cpuInstructionSet)) {
+    pathTracer->setInstructionSet(instructionSets[cpuInstructionSet]);
+    if (pathTracer->getInstructionSet() != instructionSets[cpuInstructionSet])
+      std::cerr << "--isa " << cpuInstructionSet << " isn't supported by this CPU or build" << std::endl;
+  }
+  std::cout << "instruction set: " << getInstructionSetName(pathTracer->getInstructionSet()) << std::endl;
+  if (cpuTraversal == "single") pathTracer->setTraversal(TraversalMode::SINGLE);
+  if (cpuTraversal == "packet") pathTracer->setTraversal(TraversalMode::PACKET);
+  if (cpuTraversal == "stream") pathTracer->setTraversal(TraversalMode::STREAM);
+
+  if (benchmarkTraversal) {
+    // the same frame with every mode, single ray traversal is the baseline
+    std::vector<std::tuple<std::string, TraversalMode>> modes = {{"single", TraversalMode::SINGLE},
+                                                                 {"packet", TraversalMode::PACKET},
+                                                                 {"stream", TraversalMode::STREAM},
+                                                                 {"auto", TraversalMode::AUTO}};
+    float singleTime = 0.f;
+    std::vector<glm::vec4> single;
+    for (auto& [name, mode] : modes) {
+      pathTracer->setTraversal(mode);
+      pathTracer->render(camera, settings->getResolution(), 0);
+      if (mode == TraversalMode::SINGLE) {
+        singleTime = pathTracer->getTime();
+        single = pathTracer->getResult();
+      }
+      float difference = 0.f;
+      for (int i = 0; i < single.size(); i++) {
+        glm::vec4 delta = glm::abs(pathTracer->getResult()[i] - single[i]);
+        difference = std::max({difference, delta.x, delta.y, delta.z});
+      }
+      auto shares = pathTracer->getTraversalShares();
+      std::cout << name << ": " << pathTracer->getTime() << " ms, " << pathTracer->getMraysPerSecond()
+                << " Mrays/s, x" << singleTime / pathTracer->getTime() << " of single, max difference " << difference
+                << ", rays single/packet/stream " << shares[0] << "/" << shares[1] << "/" << shares[2] << std::endl;
+    }
+    return;
+  }
+
+  std::vector<glm::vec4> accumulated(pathTracer->getResult().size(), glm::vec4(0.f));
+  for (int frame = 0; frame < cpuFrames; frame++) {
+    pathTracer->render(camera, settings->getResolution(), frame);
+    for (int i = 0; i < accumulated.size(); i++) accumulated[i] += pathTracer->getResult()[i] / (float)cpuFrames;
+    std::cout << "frame " << frame << ": " << pathTracer->getTime() << " ms, " << pathTracer->getMraysPerSecond()
+              << " Mrays/s on " << scheduler->getThreads() << " threads" << std::endl;
+  }
+  // tracer threads are idle now, they compress bands of the image
+  ImageEncoder(scheduler).save(output.empty() ? "cpu.pfm" : output, accumulated, settings->getResolution());
 }
 
-int main() {
+// no window, surface, swapchain or other parts, so it runs without display server; frames are averaged on host
+// like in renderCPU, every frame takes next samples of the sequence
+void renderHeadless() {
+  settings = std::make_shared<Settings>(std::tuple{800, 592}, 2);
+  scene = std::make_shared<Scene>(seed);
+  // start pose of the camera, Input isn't initialized without window
+  Input::direction = glm::vec3(0, 0, -1);
+  instance = std::make_shared<Instance>("Vulkan", false, nullptr);
+  device = std::make_shared<Device>(nullptr, instance, deviceName);
+  commandPool = std::make_shared<CommandPool>(device);
+  queue = std::make_shared<Queue>(device);
+  commandBuffer = std::make_shared<CommandBuffer>(settings->getMaxFramesInFlight(), commandPool, device);
+  // frames are rendered and read back one by one, there is nothing to overlap with, so all goes to graphic queue
+  tracingCommandBuffer = commandBuffer;
+  computeCommandBuffer = commandBuffer;
+  initializeCompute();
+  if (samples > 0) computePart->setAASamples(samples);
+
+  auto [width, height] = settings->getResolution();
+  // result texture is half float RGBA
+  auto stagingBuffer = std::make_shared<Buffer>(
+      static_cast<VkDeviceSize>(width) * height * 8, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, device);
+  stagingBuffer->map();
+  std::vector<glm::vec4> accumulated(width * height, glm::vec4(0.f));
+  auto startTime = std::chrono::high_resolution_clock::now();
+  for (int frame = 0; frame < cpuFrames; frame++) {
+    int slot = frame % settings->getMaxFramesInFlight();
+    commandBuffer->beginSingleTimeCommands(slot);
+    auto command = commandBuffer->getCommandBuffer()[slot];
+    computePart->draw(slot);
+
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                         &memoryBarrier, 0, nullptr, 0, nullptr);
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    vkCmdCopyImageToBuffer(command, computePart->getResultTextures()[slot]->getImageView()->getImage()->getImage(),
+                           VK_IMAGE_LAYOUT_GENERAL, stagingBuffer->getData(), 1, &region);
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0,
+                         nullptr, 0, nullptr);
+    // waits for the queue, so staging buffer can be read right away
+    commandBuffer->endSingleTimeCommands(slot, queue);
+
+    auto result = static_cast<uint64_t*>(stagingBuffer->getMappedMemory());
+    for (int i = 0; i < accumulated.size(); i++) accumulated[i] += glm::unpackHalf4x16(result[i]) / (float)cpuFrames;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - startTime).count();
+  std::cout << cpuFrames << " frames of " << computePart->getAASamples() << " samples in " << elapsed << " ms"
+            << std::endl;
+  ImageEncoder(std::make_shared<TileScheduler>())
+      .save(output.empty() ? "gpu.pfm" : output, accumulated, settings->getResolution());
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--autotune") autotune = true;
+    if (std::string(argv[i]) == "--cpu") cpu = true;
+    if (std::string(argv[i]) == "--frames" && i + 1 < argc) cpuFrames = std::max(1, std::stoi(argv[++i]));
+    if (std::string(argv[i]) == "--seed" && i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+      seedRequested = true;
+    }
+    if (std::string(argv[i]) == "--isa" && i + 1 < argc) cpuInstructionSet = argv[++i];
+    if (std::string(argv[i]) == "--benchmark-kernels") benchmarkKernels = true;
+    if (std::string(argv[i]) == "--traversal" && i + 1 < argc) cpuTraversal = argv[++i];
+    if (std::string(argv[i]) == "--benchmark-traversal") cpu = benchmarkTraversal = true;
+    if (std::string(argv[i]) == "--device" && i + 1 < argc) deviceName = argv[++i];
+    if (std::string(argv[i]) == "--list-devices") listDevices = true;
+    if (std::string(argv[i]) == "--headless") headless = true;
+    if (std::string(argv[i]) == "--samples" && i + 1 < argc) samples = std::stoi(argv[++i]);
+    if (std::string(argv[i]) == "--output" && i + 1 < argc) output = argv[++i];
+    if (std::string(argv[i]) == "--capture" && i + 1 < argc) capturePath = argv[++i];
+    if (std::string(argv[i]) == "--no-async-compute") asyncCompute = false;
+    if (std::string(argv[i]) == "--profile" && i + 1 < argc) profilePath = argv[++i];
+  }
+  // requested seed is confirmed, offline runs report the random one, so their output can be reproduced
+  if (seedRequested || cpu || headless || benchmarkKernels) std::cout << "scene seed: " << seed << std::endl;
+
   try {
+    if (benchmarkKernels) {
+      KernelBenchmark(std::make_shared<Scene>(seed), 4096).run(20);
+      return EXIT_SUCCESS;
+    }
+    if (listDevices) {
+      // surfaceless, so it works without display and ranks software devices too
+      auto headlessInstance = std::make_shared<Instance>("Vulkan", false, nullptr);
+      Device::listDevices(headlessInstance, deviceName);
+      return EXIT_SUCCESS;
+    }
+    if (cpu) {
+      renderCPU();
+      return EXIT_SUCCESS;
+    }
+    if (headless) {
+      renderHeadless();
+      return EXIT_SUCCESS;
+    }
     initialize();
     mainLoop();
   } catch (const std::exception& e) {
@@ -12,6 +12,15 @@ Buffer::Buffer(VkDeviceSize size,
   bufferInfo.size = size;
   bufferInfo.usage = usage;
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  // buffers are filled on graphic queue and used by passes on compute queue, concurrent sharing avoids ownership
+  // transfer of every buffer; images shared between queues are transferred explicitly instead
+  uint32_t queueFamilyIndices[] = {device->getSupportedGraphicsFamilyIndex().value(),
+                                   device->getSupportedComputeFamilyIndex().value()};
+  if (queueFamilyIndices[0] != queueFamilyIndices[1]) {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = 2;
+    bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+  }
 
   if (vkCreateBuffer(device->getLogicalDevice(), &bufferInfo, nullptr, &_data) != VK_SUCCESS) {
     throw std::runtime_error("failed to create buffer!");
@@ -152,4 +161,34 @@ UniformBuffer::UniformBuffer(int number,
                                           device);
 }
 
-std::vector<std::shared_ptr<Buffer>>& UniformBuffer::getBuffer() { return _buffer; }
\ No newline at end of file
+std::vector<std::shared_ptr<Buffer>>& UniformBuffer::getBuffer() { return _buffer; }
+
+StorageBuffer::StorageBuffer(VkDeviceSize size,
+                             const void* data,
+                             std::shared_ptr<CommandPool> commandPool,
+                             std::shared_ptr<Queue> queue,
+                             std::shared_ptr<Device> device) {
+  _buffer = std::make_shared<Buffer>(
+      size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device);
+
+  if (data != nullptr) {
+    auto stagingBuffer = std::make_shared<Buffer>(
+        size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, device);
+
+    void* mapped;
+    vkMapMemory(device->getLogicalDevice(), stagingBuffer->getMemory(), 0, size, 0, &mapped);
+    memcpy(mapped, data, (size_t)size);
+    vkUnmapMemory(device->getLogicalDevice(), stagingBuffer->getMemory());
+
+    _buffer->copyFrom(stagingBuffer, commandPool, queue);
+  } else {
+    auto commandBuffer = std::make_shared<CommandBuffer>(1, commandPool, device);
+    commandBuffer->beginSingleTimeCommands(0);
+    vkCmdFillBuffer(commandBuffer->getCommandBuffer()[0], _buffer->getData(), 0, VK_WHOLE_SIZE, 0);
+    commandBuffer->endSingleTimeCommands(0, queue);
+  }
+}
+
+std::shared_ptr<Buffer> StorageBuffer::getBuffer() { return _buffer; }
\ No newline at end of file
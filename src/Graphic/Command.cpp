@@ -1,14 +1,14 @@
 #include "Command.h"
 
-CommandPool::CommandPool(std::shared_ptr<Device> device) {
+CommandPool::CommandPool(std::shared_ptr<Device> device, std::optional<uint32_t> queueFamilyIndex) {
   _device = device;
   VkCommandPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
   poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-  poolInfo.queueFamilyIndex = device->getSupportedGraphicsFamilyIndex().value();
+  poolInfo.queueFamilyIndex = queueFamilyIndex.value_or(device->getSupportedGraphicsFamilyIndex().value());
 
   if (vkCreateCommandPool(device->getLogicalDevice(), &poolInfo, nullptr, &_commandPool) != VK_SUCCESS) {
-    throw std::runtime_error("failed to create graphics command pool!");
+    throw std::runtime_error("failed to create command pool!");
   }
 }
 
@@ -31,15 +31,177 @@ void DescriptorSetLayout::createCompute() {
   uboLayoutBinding3.pImmutableSamplers = nullptr;
   uboLayoutBinding3.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
-  VkDescriptorSetLayoutBinding uboLayoutBinding4{};
-  uboLayoutBinding4.binding = 4;
-  uboLayoutBinding4.descriptorCount = 1;
-  uboLayoutBinding4.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  uboLayoutBinding4.pImmutableSamplers = nullptr;
-  uboLayoutBinding4.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-
-  std::array<VkDescriptorSetLayoutBinding, 5> bindings = {uboLayoutBinding, imageLayoutBinding, uboLayoutBinding2,
-                                                          uboLayoutBinding3, uboLayoutBinding4};
+  VkDescriptorSetLayoutBinding storageLayoutBinding{};
+  storageLayoutBinding.binding = 4;
+  storageLayoutBinding.descriptorCount = 1;
+  storageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  storageLayoutBinding.pImmutableSamplers = nullptr;
+  storageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutBinding albedoLayoutBinding{};
+  albedoLayoutBinding.binding = 5;
+  albedoLayoutBinding.descriptorCount = 1;
+  albedoLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  albedoLayoutBinding.pImmutableSamplers = nullptr;
+  albedoLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutBinding normalDepthLayoutBinding{};
+  normalDepthLayoutBinding.binding = 6;
+  normalDepthLayoutBinding.descriptorCount = 1;
+  normalDepthLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  normalDepthLayoutBinding.pImmutableSamplers = nullptr;
+  normalDepthLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutBinding lightsLayoutBinding{};
+  lightsLayoutBinding.binding = 7;
+  lightsLayoutBinding.descriptorCount = 1;
+  lightsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  lightsLayoutBinding.pImmutableSamplers = nullptr;
+  lightsLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutBinding lightTreeLayoutBinding{};
+  lightTreeLayoutBinding.binding = 8;
+  lightTreeLayoutBinding.descriptorCount = 1;
+  lightTreeLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  lightTreeLayoutBinding.pImmutableSamplers = nullptr;
+  lightTreeLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutBinding cacheLayoutBinding{};
+  cacheLayoutBinding.binding = 9;
+  cacheLayoutBinding.descriptorCount = 1;
+  cacheLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  cacheLayoutBinding.pImmutableSamplers = nullptr;
+  cacheLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutBinding guideLayoutBinding{};
+  guideLayoutBinding.binding = 10;
+  guideLayoutBinding.descriptorCount = 1;
+  guideLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  guideLayoutBinding.pImmutableSamplers = nullptr;
+  guideLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  std::array<VkDescriptorSetLayoutBinding, 11> bindings = {
+      uboLayoutBinding,         imageLayoutBinding,  uboLayoutBinding2,      uboLayoutBinding3,
+      storageLayoutBinding,     albedoLayoutBinding, normalDepthLayoutBinding, lightsLayoutBinding,
+      lightTreeLayoutBinding,   cacheLayoutBinding,  guideLayoutBinding};
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(_device->getLogicalDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor set layout!");
+  }
+}
+
+void DescriptorSetLayout::createDenoise() {
+  // input color, albedo, normal + depth and output color
+  std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+  for (int i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[i].pImmutableSamplers = nullptr;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(_device->getLogicalDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor set layout!");
+  }
+}
+
+void DescriptorSetLayout::createPostprocess() {
+  // HDR input color, display output color, luminance histogram and exposure
+  std::array<VkDescriptorType, 4> types = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+  std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+  for (int i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = types[i];
+    bindings[i].pImmutableSamplers = nullptr;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(_device->getLogicalDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor set layout!");
+  }
+}
+
+void DescriptorSetLayout::createTemporal() {
+  // cameras, then current color, current normal + depth, history, previous normal + depth and output
+  std::array<VkDescriptorSetLayoutBinding, 6> bindings{};
+  for (int i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[i].pImmutableSamplers = nullptr;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(_device->getLogicalDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor set layout!");
+  }
+}
+
+void DescriptorSetLayout::createReSTIR() {
+  // parameters, spheres, hitboxes, lights, then albedo, normal + depth, previous normal + depth, color,
+  // initial, final and history reservoirs, statistics
+  std::array<VkDescriptorType, 12> types = {
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+      VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+  std::array<VkDescriptorSetLayoutBinding, 12> bindings{};
+  for (int i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = types[i];
+    bindings[i].pImmutableSamplers = nullptr;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(_device->getLogicalDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor set layout!");
+  }
+}
+
+void DescriptorSetLayout::createCache() {
+  // cache cells and statistics
+  std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+  for (int i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].pImmutableSamplers = nullptr;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
   VkDescriptorSetLayoutCreateInfo layoutInfo{};
   layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
   layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -114,13 +276,15 @@ DescriptorSetLayout::~DescriptorSetLayout() {
 DescriptorPool::DescriptorPool(int number, std::shared_ptr<Device> device) {
   _device = device;
 
-  std::array<VkDescriptorPoolSize, 3> poolSizes{};
+  std::array<VkDescriptorPoolSize, 4> poolSizes{};
   poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
   poolSizes[0].descriptorCount = static_cast<uint32_t>(number);
   poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
   poolSizes[1].descriptorCount = static_cast<uint32_t>(number);
   poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
   poolSizes[2].descriptorCount = static_cast<uint32_t>(number);
+  poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  poolSizes[3].descriptorCount = static_cast<uint32_t>(number);
 
   VkDescriptorPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -230,7 +394,13 @@ void DescriptorSet::createCompute(std::vector<std::shared_ptr<Texture>> textureO
                                   std::shared_ptr<UniformBuffer> uniformBuffer,
                                   std::shared_ptr<UniformBuffer> uniformSpheres,
                                   std::shared_ptr<UniformBuffer> uniformHitboxes,
-                                  std::shared_ptr<UniformBuffer> uniformSettings) {
+                                  std::shared_ptr<StorageBuffer> storageSobol,
+                                  std::vector<std::shared_ptr<Texture>> albedoOut,
+                                  std::vector<std::shared_ptr<Texture>> normalDepthOut,
+                                  std::shared_ptr<StorageBuffer> storageLights,
+                                  std::shared_ptr<StorageBuffer> storageLightTree,
+                                  std::shared_ptr<StorageBuffer> storageCache,
+                                  std::shared_ptr<StorageBuffer> storageGuide) {
   for (size_t i = 0; i < _descriptorSets.size(); i++) {
     VkDescriptorBufferInfo bufferInfo{};
     bufferInfo.buffer = uniformBuffer->getBuffer()[i]->getData();
@@ -248,15 +418,43 @@ void DescriptorSet::createCompute(std::vector<std::shared_ptr<Texture>> textureO
     bufferInfo3.range = uniformHitboxes->getBuffer()[i]->getSize();
 
     VkDescriptorBufferInfo bufferInfo4{};
-    bufferInfo4.buffer = uniformSettings->getBuffer()[i]->getData();
+    bufferInfo4.buffer = storageSobol->getBuffer()->getData();
     bufferInfo4.offset = 0;
-    bufferInfo4.range = uniformSettings->getBuffer()[i]->getSize();
+    bufferInfo4.range = storageSobol->getBuffer()->getSize();
+
+    VkDescriptorBufferInfo bufferInfo5{};
+    bufferInfo5.buffer = storageLights->getBuffer()->getData();
+    bufferInfo5.offset = 0;
+    bufferInfo5.range = storageLights->getBuffer()->getSize();
+
+    VkDescriptorBufferInfo bufferInfo6{};
+    bufferInfo6.buffer = storageLightTree->getBuffer()->getData();
+    bufferInfo6.offset = 0;
+    bufferInfo6.range = storageLightTree->getBuffer()->getSize();
+
+    VkDescriptorBufferInfo bufferInfo7{};
+    bufferInfo7.buffer = storageCache->getBuffer()->getData();
+    bufferInfo7.offset = 0;
+    bufferInfo7.range = storageCache->getBuffer()->getSize();
+
+    VkDescriptorBufferInfo bufferInfo8{};
+    bufferInfo8.buffer = storageGuide->getBuffer()->getData();
+    bufferInfo8.offset = 0;
+    bufferInfo8.range = storageGuide->getBuffer()->getSize();
 
     VkDescriptorImageInfo imageInfoOut{};
     imageInfoOut.imageLayout = textureOut[i]->getImageView()->getImage()->getImageLayout();
     imageInfoOut.imageView = textureOut[i]->getImageView()->getImageView();
 
-    std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
+    VkDescriptorImageInfo imageInfoAlbedo{};
+    imageInfoAlbedo.imageLayout = albedoOut[i]->getImageView()->getImage()->getImageLayout();
+    imageInfoAlbedo.imageView = albedoOut[i]->getImageView()->getImageView();
+
+    VkDescriptorImageInfo imageInfoNormalDepth{};
+    imageInfoNormalDepth.imageLayout = normalDepthOut[i]->getImageView()->getImage()->getImageLayout();
+    imageInfoNormalDepth.imageView = normalDepthOut[i]->getImageView()->getImageView();
+
+    std::array<VkWriteDescriptorSet, 11> descriptorWrites{};
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].dstSet = _descriptorSets[i];
     descriptorWrites[0].dstBinding = 0;
@@ -293,10 +491,249 @@ void DescriptorSet::createCompute(std::vector<std::shared_ptr<Texture>> textureO
     descriptorWrites[4].dstSet = _descriptorSets[i];
     descriptorWrites[4].dstBinding = 4;
     descriptorWrites[4].dstArrayElement = 0;
-    descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     descriptorWrites[4].descriptorCount = 1;
     descriptorWrites[4].pBufferInfo = &bufferInfo4;
 
+    descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[5].dstSet = _descriptorSets[i];
+    descriptorWrites[5].dstBinding = 5;
+    descriptorWrites[5].dstArrayElement = 0;
+    descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    descriptorWrites[5].descriptorCount = 1;
+    descriptorWrites[5].pImageInfo = &imageInfoAlbedo;
+
+    descriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[6].dstSet = _descriptorSets[i];
+    descriptorWrites[6].dstBinding = 6;
+    descriptorWrites[6].dstArrayElement = 0;
+    descriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    descriptorWrites[6].descriptorCount = 1;
+    descriptorWrites[6].pImageInfo = &imageInfoNormalDepth;
+
+    descriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[7].dstSet = _descriptorSets[i];
+    descriptorWrites[7].dstBinding = 7;
+    descriptorWrites[7].dstArrayElement = 0;
+    descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[7].descriptorCount = 1;
+    descriptorWrites[7].pBufferInfo = &bufferInfo5;
+
+    descriptorWrites[8].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[8].dstSet = _descriptorSets[i];
+    descriptorWrites[8].dstBinding = 8;
+    descriptorWrites[8].dstArrayElement = 0;
+    descriptorWrites[8].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[8].descriptorCount = 1;
+    descriptorWrites[8].pBufferInfo = &bufferInfo6;
+
+    descriptorWrites[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[9].dstSet = _descriptorSets[i];
+    descriptorWrites[9].dstBinding = 9;
+    descriptorWrites[9].dstArrayElement = 0;
+    descriptorWrites[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[9].descriptorCount = 1;
+    descriptorWrites[9].pBufferInfo = &bufferInfo7;
+
+    descriptorWrites[10].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[10].dstSet = _descriptorSets[i];
+    descriptorWrites[10].dstBinding = 10;
+    descriptorWrites[10].dstArrayElement = 0;
+    descriptorWrites[10].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[10].descriptorCount = 1;
+    descriptorWrites[10].pBufferInfo = &bufferInfo8;
+
+    vkUpdateDescriptorSets(_device->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+  }
+}
+
+void DescriptorSet::createDenoise(std::vector<std::shared_ptr<Texture>> textureIn,
+                                  std::vector<std::shared_ptr<Texture>> albedo,
+                                  std::vector<std::shared_ptr<Texture>> normalDepth,
+                                  std::vector<std::shared_ptr<Texture>> textureOut) {
+  for (size_t i = 0; i < _descriptorSets.size(); i++) {
+    std::array<std::shared_ptr<Texture>, 4> textures = {textureIn[i], albedo[i], normalDepth[i], textureOut[i]};
+    std::array<VkDescriptorImageInfo, 4> imageInfo{};
+    std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+    for (int j = 0; j < textures.size(); j++) {
+      imageInfo[j].imageLayout = textures[j]->getImageView()->getImage()->getImageLayout();
+      imageInfo[j].imageView = textures[j]->getImageView()->getImageView();
+
+      descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrites[j].dstSet = _descriptorSets[i];
+      descriptorWrites[j].dstBinding = j;
+      descriptorWrites[j].dstArrayElement = 0;
+      descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+      descriptorWrites[j].descriptorCount = 1;
+      descriptorWrites[j].pImageInfo = &imageInfo[j];
+    }
+
+    vkUpdateDescriptorSets(_device->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+  }
+}
+
+void DescriptorSet::createTemporal(std::shared_ptr<UniformBuffer> uniformBuffer,
+                                   std::vector<std::shared_ptr<Texture>> textureIn,
+                                   std::vector<std::shared_ptr<Texture>> normalDepth,
+                                   std::vector<std::shared_ptr<Texture>> history,
+                                   std::vector<std::shared_ptr<Texture>> historyNormalDepth,
+                                   std::vector<std::shared_ptr<Texture>> textureOut) {
+  for (size_t i = 0; i < _descriptorSets.size(); i++) {
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = uniformBuffer->getBuffer()[i]->getData();
+    bufferInfo.offset = 0;
+    bufferInfo.range = uniformBuffer->getBuffer()[i]->getSize();
+
+    std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = _descriptorSets[i];
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].dstArrayElement = 0;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+    std::array<std::shared_ptr<Texture>, 5> textures = {textureIn[i], normalDepth[i], history[i],
+                                                        historyNormalDepth[i], textureOut[i]};
+    std::array<VkDescriptorImageInfo, 5> imageInfo{};
+    for (int j = 0; j < textures.size(); j++) {
+      imageInfo[j].imageLayout = textures[j]->getImageView()->getImage()->getImageLayout();
+      imageInfo[j].imageView = textures[j]->getImageView()->getImageView();
+
+      descriptorWrites[j + 1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrites[j + 1].dstSet = _descriptorSets[i];
+      descriptorWrites[j + 1].dstBinding = j + 1;
+      descriptorWrites[j + 1].dstArrayElement = 0;
+      descriptorWrites[j + 1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+      descriptorWrites[j + 1].descriptorCount = 1;
+      descriptorWrites[j + 1].pImageInfo = &imageInfo[j];
+    }
+
+    vkUpdateDescriptorSets(_device->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+  }
+}
+
+void DescriptorSet::createReSTIR(std::shared_ptr<UniformBuffer> uniformBuffer,
+                                 std::shared_ptr<UniformBuffer> uniformSpheres,
+                                 std::shared_ptr<UniformBuffer> uniformHitboxes,
+                                 std::shared_ptr<StorageBuffer> storageLights,
+                                 std::vector<std::shared_ptr<Texture>> albedo,
+                                 std::vector<std::shared_ptr<Texture>> normalDepth,
+                                 std::vector<std::shared_ptr<Texture>> historyNormalDepth,
+                                 std::vector<std::shared_ptr<Texture>> textureOut,
+                                 std::vector<std::shared_ptr<StorageBuffer>> initialReservoirs,
+                                 std::vector<std::shared_ptr<StorageBuffer>> finalReservoirs,
+                                 std::vector<std::shared_ptr<StorageBuffer>> historyReservoirs,
+                                 std::vector<std::shared_ptr<Buffer>> statistics) {
+  for (size_t i = 0; i < _descriptorSets.size(); i++) {
+    std::array<VkWriteDescriptorSet, 12> descriptorWrites{};
+    for (int j = 0; j < descriptorWrites.size(); j++) {
+      descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrites[j].dstSet = _descriptorSets[i];
+      descriptorWrites[j].dstBinding = j;
+      descriptorWrites[j].dstArrayElement = 0;
+      descriptorWrites[j].descriptorCount = 1;
+    }
+
+    // bindings 0-3 and 8-11
+    std::array<std::shared_ptr<Buffer>, 8> buffers = {uniformBuffer->getBuffer()[i],
+                                                      uniformSpheres->getBuffer()[i],
+                                                      uniformHitboxes->getBuffer()[i],
+                                                      storageLights->getBuffer(),
+                                                      initialReservoirs[i]->getBuffer(),
+                                                      finalReservoirs[i]->getBuffer(),
+                                                      historyReservoirs[i]->getBuffer(),
+                                                      statistics[i]};
+    std::array<VkDescriptorBufferInfo, 8> bufferInfo{};
+    for (int j = 0; j < buffers.size(); j++) {
+      int binding = j < 4 ? j : j + 4;
+      bufferInfo[j].buffer = buffers[j]->getData();
+      bufferInfo[j].offset = 0;
+      bufferInfo[j].range = buffers[j]->getSize();
+      descriptorWrites[binding].descriptorType = j < 3 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                                                       : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      descriptorWrites[binding].pBufferInfo = &bufferInfo[j];
+    }
+
+    // bindings 4-7
+    std::array<std::shared_ptr<Texture>, 4> textures = {albedo[i], normalDepth[i], historyNormalDepth[i],
+                                                        textureOut[i]};
+    std::array<VkDescriptorImageInfo, 4> imageInfo{};
+    for (int j = 0; j < textures.size(); j++) {
+      imageInfo[j].imageLayout = textures[j]->getImageView()->getImage()->getImageLayout();
+      imageInfo[j].imageView = textures[j]->getImageView()->getImageView();
+      descriptorWrites[j + 4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+      descriptorWrites[j + 4].pImageInfo = &imageInfo[j];
+    }
+
+    vkUpdateDescriptorSets(_device->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+  }
+}
+
+void DescriptorSet::createCache(std::shared_ptr<StorageBuffer> storageCache,
+                                std::vector<std::shared_ptr<Buffer>> statistics) {
+  for (size_t i = 0; i < _descriptorSets.size(); i++) {
+    std::array<std::shared_ptr<Buffer>, 2> buffers = {storageCache->getBuffer(), statistics[i]};
+    std::array<VkDescriptorBufferInfo, 2> bufferInfo{};
+    std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+    for (int j = 0; j < buffers.size(); j++) {
+      bufferInfo[j].buffer = buffers[j]->getData();
+      bufferInfo[j].offset = 0;
+      bufferInfo[j].range = buffers[j]->getSize();
+
+      descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrites[j].dstSet = _descriptorSets[i];
+      descriptorWrites[j].dstBinding = j;
+      descriptorWrites[j].dstArrayElement = 0;
+      descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      descriptorWrites[j].descriptorCount = 1;
+      descriptorWrites[j].pBufferInfo = &bufferInfo[j];
+    }
+
+    vkUpdateDescriptorSets(_device->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+  }
+}
+
+void DescriptorSet::createPostprocess(std::vector<std::shared_ptr<Texture>> textureIn,
+                                  std::vector<std::shared_ptr<Texture>> textureOut,
+                                  std::shared_ptr<StorageBuffer> histogram,
+                                  std::shared_ptr<StorageBuffer> exposure) {
+  for (size_t i = 0; i < _descriptorSets.size(); i++) {
+    std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+    for (int j = 0; j < descriptorWrites.size(); j++) {
+      descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrites[j].dstSet = _descriptorSets[i];
+      descriptorWrites[j].dstBinding = j;
+      descriptorWrites[j].dstArrayElement = 0;
+      descriptorWrites[j].descriptorCount = 1;
+    }
+
+    // bindings 0-1
+    std::array<std::shared_ptr<Texture>, 2> textures = {textureIn[i], textureOut[i]};
+    std::array<VkDescriptorImageInfo, 2> imageInfo{};
+    for (int j = 0; j < textures.size(); j++) {
+      imageInfo[j].imageLayout = textures[j]->getImageView()->getImage()->getImageLayout();
+      imageInfo[j].imageView = textures[j]->getImageView()->getImageView();
+      descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+      descriptorWrites[j].pImageInfo = &imageInfo[j];
+    }
+
+    // bindings 2-3
+    std::array<std::shared_ptr<Buffer>, 2> buffers = {histogram->getBuffer(), exposure->getBuffer()};
+    std::array<VkDescriptorBufferInfo, 2> bufferInfo{};
+    for (int j = 0; j < buffers.size(); j++) {
+      bufferInfo[j].buffer = buffers[j]->getData();
+      bufferInfo[j].offset = 0;
+      bufferInfo[j].range = buffers[j]->getSize();
+      descriptorWrites[j + 2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      descriptorWrites[j + 2].pBufferInfo = &bufferInfo[j];
+    }
+
     vkUpdateDescriptorSets(_device->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()),
                            descriptorWrites.data(), 0, nullptr);
   }
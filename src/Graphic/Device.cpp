@@ -1,4 +1,7 @@
 #include "Device.h"
+#include <map>
+#include <algorithm>
+#include <cctype>
 
 std::vector<VkPresentModeKHR>& Device::getSupportedSurfacePresentModes() { return _surfacePresentModes; }
 
@@ -13,6 +16,13 @@ std::optional<uint32_t> Device::getSupportedPresentFamilyIndex() { return _prese
 std::optional<uint32_t> Device::getSupportedComputeFamilyIndex() { return _computeFamily; }
 
 bool Device::_isDeviceSuitable(VkPhysicalDevice device) {
+  // values of the previously checked device must not leak to this one
+  _graphicsFamily.reset();
+  _presentFamily.reset();
+  _computeFamily.reset();
+  _surfaceFormats.clear();
+  _surfacePresentModes.clear();
+
   // check if queue supported
   uint32_t queueFamilyCount = 0;
   vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
@@ -22,22 +32,28 @@ bool Device::_isDeviceSuitable(VkPhysicalDevice device) {
 
   int i = 0;
   for (const auto& queueFamily : queueFamilies) {
-    if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+    // the search goes on for dedicated compute family, the first graphics and present families are kept
+    if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && _graphicsFamily.has_value() == false) {
       _graphicsFamily = i;
     }
 
-    if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
+    // family without graphics runs compute next to graphics work, family with graphics is only a fallback
+    if ((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+        (_computeFamily.has_value() == false || (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0)) {
       _computeFamily = i;
     }
 
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface->getSurface(), &presentSupport);
+    if (_surface) {
+      VkBool32 presentSupport = false;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface->getSurface(), &presentSupport);
 
-    if (presentSupport) {
-      _presentFamily = i;
+      if (presentSupport && _presentFamily.has_value() == false) {
+        _presentFamily = i;
+      }
     }
 
-    if (_presentFamily.has_value() && _graphicsFamily.has_value() && _computeFamily.has_value()) {
+    if ((_presentFamily.has_value() || _surface == nullptr) && _graphicsFamily.has_value() &&
+        _computeFamily.has_value() && _computeFamily != _graphicsFamily) {
       break;
     }
 
@@ -58,8 +74,8 @@ bool Device::_isDeviceSuitable(VkPhysicalDevice device) {
   }
 
   // check surface capabilities
-  bool swapChainAdequate = false;
-  if (requiredExtensions.empty()) {
+  bool swapChainAdequate = _surface == nullptr;
+  if (_surface && requiredExtensions.empty()) {
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, _surface->getSurface(), &_surfaceCapabilities);
 
     uint32_t formatCount;
@@ -85,8 +101,59 @@ bool Device::_isDeviceSuitable(VkPhysicalDevice device) {
   // check device features
   vkGetPhysicalDeviceFeatures(device, &_supportedFeatures);
 
-  return _presentFamily.has_value() && _graphicsFamily.has_value() && _computeFamily.has_value() &&
-         requiredExtensions.empty() && swapChainAdequate && _supportedFeatures.samplerAnisotropy;
+  // anisotropic filtering isn't used by samplers, so devices without it (some software ones) are fine
+  return (_presentFamily.has_value() || _surface == nullptr) && _graphicsFamily.has_value() &&
+         _computeFamily.has_value() && requiredExtensions.empty() && swapChainAdequate;
+}
+
+float Device::_scoreDevice(VkPhysicalDevice device) {
+  if (_isDeviceSuitable(device) == false) return -1.f;
+
+  VkPhysicalDeviceProperties props;
+  vkGetPhysicalDeviceProperties(device, &props);
+  float score = 0.f;
+  switch (props.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      score = 4000.f;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      score = 3000.f;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+      score = 2000.f;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      score = 1000.f;
+      break;
+    default:
+      break;
+  }
+
+  // device local memory, 10 per GB up to 64 GB, so it never outweighs the type
+  VkPhysicalDeviceMemoryProperties memory;
+  vkGetPhysicalDeviceMemoryProperties(device, &memory);
+  VkDeviceSize localMemory = 0;
+  for (int i = 0; i < memory.memoryHeapCount; i++) {
+    if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) localMemory += memory.memoryHeaps[i].size;
+  }
+  score += std::min(localMemory / float(1 << 30), 64.f) * 10.f;
+
+  // queue family with compute but without graphics lets compute run next to graphics
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+  for (const auto& queueFamily : queueFamilies) {
+    if ((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0) {
+      score += 50.f;
+      break;
+    }
+  }
+
+  // compute limits used by the raytracing and denoise shaders
+  score += std::min(props.limits.maxComputeSharedMemorySize / 1024.f, 64.f);
+  score += std::min(props.limits.maxComputeWorkGroupInvocations / 64.f, 32.f);
+  return score;
 }
 
 void Device::_pickPhysicalDevice() {
@@ -100,23 +167,78 @@ void Device::_pickPhysicalDevice() {
   std::vector<VkPhysicalDevice> devices(deviceCount);
   vkEnumeratePhysicalDevices(_instance->getInstance(), &deviceCount, devices.data());
 
-  for (const auto& device : devices) {
+  std::map<VkPhysicalDeviceType, std::string> typeNames = {{VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, "discrete"},
+                                                          {VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, "integrated"},
+                                                          {VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU, "virtual"},
+                                                          {VK_PHYSICAL_DEVICE_TYPE_CPU, "cpu"}};
+  auto lower = [](std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+  };
+  bool byIndex = _preferred.empty() == false &&
+                 std::all_of(_preferred.begin(), _preferred.end(), [](unsigned char c) { return std::isdigit(c); });
+  // index which doesn't fit int matches no device, so the best ranked one is used like for any missing index
+  int preferredIndex = -1;
+  if (byIndex) {
+    try {
+      preferredIndex = std::stoi(_preferred);
+    } catch (const std::out_of_range&) {
+      std::cout << "invalid device index " << _preferred << std::endl;
+    }
+  }
+
+  float bestScore = -1.f;
+  VkPhysicalDevice preferred = VK_NULL_HANDLE;
+  for (int i = 0; i < devices.size(); i++) {
     VkPhysicalDeviceProperties props;
-    vkGetPhysicalDeviceProperties(device, &props);
-    if (_isDeviceSuitable(device) && props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-      _physicalDevice = device;
-      break;
+    vkGetPhysicalDeviceProperties(devices[i], &props);
+    float score = _scoreDevice(devices[i]);
+    std::string type = typeNames.contains(props.deviceType) ? typeNames[props.deviceType] : "other";
+    std::cout << "device " << i << ": " << props.deviceName << " (" << type << "), score ";
+    if (score < 0.f)
+      std::cout << "unsuitable" << std::endl;
+    else
+      std::cout << score << std::endl;
+    if (score < 0.f) continue;
+
+    if (score > bestScore) {
+      bestScore = score;
+      _physicalDevice = devices[i];
+    }
+    bool matches = byIndex ? preferredIndex == i : lower(props.deviceName).find(lower(_preferred)) != std::string::npos;
+    if (_preferred.empty() == false && matches && preferred == VK_NULL_HANDLE) preferred = devices[i];
+  }
+
+  if (_preferred.empty() == false) {
+    if (preferred == VK_NULL_HANDLE) {
+      std::cout << "requested device " << _preferred << " isn't found or isn't suitable, the best ranked is used"
+                << std::endl;
+    } else {
+      _physicalDevice = preferred;
     }
   }
 
   if (_physicalDevice == VK_NULL_HANDLE) {
     throw std::runtime_error("failed to find a suitable GPU!");
   }
+  // queue families and surface capabilities of the picked device
+  _isDeviceSuitable(_physicalDevice);
+
+  vkGetPhysicalDeviceProperties(_physicalDevice, &_deviceProperties);
+  std::cout << "picked device: " << _deviceProperties.deviceName << std::endl;
+  if (_deviceProperties.apiVersion >= VK_API_VERSION_1_1) {
+    _subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &_subgroupProperties;
+    vkGetPhysicalDeviceProperties2(_physicalDevice, &properties);
+  }
 }
 
 void Device::_createLogicalDevice() {
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {_graphicsFamily.value(), _presentFamily.value(), _computeFamily.value()};
+  std::set<uint32_t> uniqueQueueFamilies = {_graphicsFamily.value(), _computeFamily.value()};
+  if (_presentFamily.has_value()) uniqueQueueFamilies.insert(_presentFamily.value());
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -129,7 +251,7 @@ void Device::_createLogicalDevice() {
   }
 
   VkPhysicalDeviceFeatures deviceFeatures{};
-  deviceFeatures.samplerAnisotropy = VK_TRUE;
+  deviceFeatures.samplerAnisotropy = _supportedFeatures.samplerAnisotropy;
 
   VkDeviceCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -169,15 +291,35 @@ VkFormat Device::findDepthBufferSupportedFormat(const std::vector<VkFormat>& can
   throw std::runtime_error("failed to find supported format!");
 }
 
-Device::Device(std::shared_ptr<Surface> surface, std::shared_ptr<Instance> instance) {
+bool Device::isFormatFeatureSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features) {
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(_physicalDevice, format, &props);
+  if (tiling == VK_IMAGE_TILING_LINEAR) return (props.linearTilingFeatures & features) == features;
+  return (props.optimalTilingFeatures & features) == features;
+}
+
+Device::Device(std::shared_ptr<Surface> surface, std::shared_ptr<Instance> instance, std::string preferred) {
   _instance = instance;
   _surface = surface;
+  _preferred = preferred;
+  if (_surface) _deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
   _pickPhysicalDevice();
   _createLogicalDevice();
 }
 
+void Device::listDevices(std::shared_ptr<Instance> instance, std::string preferred) {
+  Device device;
+  device._instance = instance;
+  device._preferred = preferred;
+  device._pickPhysicalDevice();
+}
+
 VkDevice& Device::getLogicalDevice() { return _logicalDevice; }
 
 VkPhysicalDevice& Device::getPhysicalDevice() { return _physicalDevice; }
 
+const VkPhysicalDeviceProperties& Device::getDeviceProperties() { return _deviceProperties; }
+
+const VkPhysicalDeviceSubgroupProperties& Device::getSubgroupProperties() { return _subgroupProperties; }
+
 Device::~Device() { vkDestroyDevice(_logicalDevice, nullptr); }
\ No newline at end of file
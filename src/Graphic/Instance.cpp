@@ -46,14 +46,16 @@ Instance::Instance(std::string name, bool validation, std::shared_ptr<Window> wi
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);
+  // 1.1 for subgroup operations in compute shaders
+  appInfo.apiVersion = VK_MAKE_API_VERSION(0, 1, 1, 0);
 
   VkInstanceCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
   createInfo.pApplicationInfo = &appInfo;
 
-  // extensions
-  std::vector<const char*> extensions = window->getExtensions();
+  // extensions, without window nothing is presented and surface extensions aren't needed
+  std::vector<const char*> extensions;
+  if (window) extensions = window->getExtensions();
   if (_validation) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
@@ -3,10 +3,12 @@
 
 Pipeline::Pipeline(std::shared_ptr<Shader> shader,
                    std::shared_ptr<DescriptorSetLayout> descriptorSetLayout,
-                   std::shared_ptr<Device> device) {
+                   std::shared_ptr<Device> device,
+                   int maxVariants) {
   _device = device;
   _shader = shader;
   _descriptorSetLayout = descriptorSetLayout;
+  _maxVariants = maxVariants;
 }
 
 void Pipeline::createGUI(VkVertexInputBindingDescription bindingDescription,
@@ -229,25 +231,146 @@ void Pipeline::createGraphic(VkVertexInputBindingDescription bindingDescription,
   }
 }
 
-void Pipeline::createCompute() {
-  // create pipeline layout
+std::vector<char> Pipeline::_getKey(VkSpecializationInfo* specializationInfo) {
+  if (specializationInfo == nullptr) return {};
+  auto data = static_cast<const char*>(specializationInfo->pData);
+  return std::vector<char>(data, data + specializationInfo->dataSize);
+}
+
+void Pipeline::_createLayout(std::vector<VkPushConstantRange> pushConstants) {
+  // layout doesn't depend on specialization constants, so it's shared between all variants
+  if (_pipelineLayout != VK_NULL_HANDLE) return;
   VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   pipelineLayoutInfo.setLayoutCount = 1;
   pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout->getDescriptorSetLayout();
+  pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+  pipelineLayoutInfo.pPushConstantRanges = pushConstants.data();
 
   if (vkCreatePipelineLayout(_device->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &_pipelineLayout) !=
       VK_SUCCESS) {
     throw std::runtime_error("failed to create pipeline layout!");
   }
+}
+
+std::future<VkPipeline> Pipeline::_compile(VkSpecializationInfo* specializationInfo, std::launch policy) {
+  std::vector<VkSpecializationMapEntry> entries;
+  std::vector<char> data = _getKey(specializationInfo);
+  if (specializationInfo != nullptr)
+    entries.assign(specializationInfo->pMapEntries,
+                   specializationInfo->pMapEntries + specializationInfo->mapEntryCount);
+  bool specialized = specializationInfo != nullptr;
+
+  // pipeline creation doesn't need external synchronization of the device, so it runs next to rendering
+  return std::async(policy, [this, entries, data, specialized]() {
+    VkSpecializationInfo info{};
+    info.mapEntryCount = static_cast<uint32_t>(entries.size());
+    info.pMapEntries = entries.data();
+    info.dataSize = data.size();
+    info.pData = data.data();
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo{};
+    computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    computePipelineCreateInfo.layout = _pipelineLayout;
+    computePipelineCreateInfo.flags = 0;
+    computePipelineCreateInfo.stage = _shader->getShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    computePipelineCreateInfo.stage.pSpecializationInfo = specialized ? &info : nullptr;
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(_device->getLogicalDevice(), VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr,
+                                 &pipeline) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create compute pipeline!");
+    }
+    return pipeline;
+  });
+}
+
+void Pipeline::_use(std::vector<char> key, VkPipeline pipeline) {
+  _variants[key] = {pipeline, _selections};
+  _pipeline = pipeline;
+  _evict();
+}
+
+void Pipeline::_evict() {
+  // frames in flight are far fewer than this many selections, so retired pipelines aren't used anymore
+  const uint64_t retireDelay = 8;
+  std::erase_if(_retired, [&](auto& retired) {
+    auto [pipeline, selection] = retired;
+    if (_selections - selection < retireDelay) return false;
+    vkDestroyPipeline(_device->getLogicalDevice(), pipeline, nullptr);
+    return true;
+  });
+
+  while (_variants.size() > static_cast<size_t>(_maxVariants)) {
+    auto oldest = _variants.end();
+    for (auto it = _variants.begin(); it != _variants.end(); it++) {
+      if (it->second.pipeline == _pipeline) continue;
+      if (oldest == _variants.end() || it->second.lastUse < oldest->second.lastUse) oldest = it;
+    }
+    if (oldest == _variants.end()) break;
+    _retired.push_back({oldest->second.pipeline, _selections});
+    _variants.erase(oldest);
+  }
+}
+
+void Pipeline::createCompute(VkSpecializationInfo* specializationInfo,
+                             std::vector<VkPushConstantRange> pushConstants) {
+  _selections++;
+  auto key = _getKey(specializationInfo);
+  auto variant = _variants.find(key);
+  if (variant != _variants.end()) {
+    variant->second.lastUse = _selections;
+    _pipeline = variant->second.pipeline;
+    return;
+  }
+
+  _createLayout(pushConstants);
+  auto pending = _pending.find(key);
+  if (pending != _pending.end()) {
+    auto pipeline = pending->second.get();
+    _pending.erase(pending);
+    _use(key, pipeline);
+    return;
+  }
+  _use(key, _compile(specializationInfo, std::launch::deferred).get());
+}
+
+bool Pipeline::selectCompute(VkSpecializationInfo* specializationInfo,
+                             std::vector<VkPushConstantRange> pushConstants) {
+  auto key = _getKey(specializationInfo);
+  // nothing to keep bound yet, so the first variant is compiled right away
+  if (_pipeline == VK_NULL_HANDLE || _variants.contains(key)) {
+    createCompute(specializationInfo, pushConstants);
+    return true;
+  }
 
-  VkComputePipelineCreateInfo computePipelineCreateInfo{};
-  computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-  computePipelineCreateInfo.layout = _pipelineLayout;
-  computePipelineCreateInfo.flags = 0;
-  computePipelineCreateInfo.stage = _shader->getShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
-  vkCreateComputePipelines(_device->getLogicalDevice(), VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr,
-                           &_pipeline);
+  _selections++;
+  // the current variant is still used this frame
+  for (auto& [variantKey, variant] : _variants)
+    if (variant.pipeline == _pipeline) variant.lastUse = _selections;
+
+  auto pending = _pending.find(key);
+  if (pending == _pending.end()) {
+    // finished variants nobody asked for again were superseded by settings changes, so only running jobs stay
+    for (auto job = _pending.begin(); job != _pending.end();) {
+      if (job->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        job++;
+        continue;
+      }
+      try {
+        vkDestroyPipeline(_device->getLogicalDevice(), job->second.get(), nullptr);
+      } catch (const std::exception&) {
+        // failed variant has no pipeline, the error shows up if it's selected again
+      }
+      job = _pending.erase(job);
+    }
+    _pending[key] = _compile(specializationInfo, std::launch::async);
+    return false;
+  }
+  if (pending->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+  auto pipeline = pending->second.get();
+  _pending.erase(pending);
+  _use(key, pipeline);
+  return true;
 }
 
 VkPipeline& Pipeline::getPipeline() { return _pipeline; }
@@ -255,6 +378,16 @@ VkPipeline& Pipeline::getPipeline() { return _pipeline; }
 VkPipelineLayout& Pipeline::getPipelineLayout() { return _pipelineLayout; }
 
 Pipeline::~Pipeline() {
-  vkDestroyPipeline(_device->getLogicalDevice(), _pipeline, nullptr);
+  if (_variants.empty()) vkDestroyPipeline(_device->getLogicalDevice(), _pipeline, nullptr);
+  for (auto& [key, variant] : _variants) vkDestroyPipeline(_device->getLogicalDevice(), variant.pipeline, nullptr);
+  // compilations still running have to finish before their pipelines and the layout are destroyed
+  for (auto& [key, pending] : _pending) {
+    try {
+      vkDestroyPipeline(_device->getLogicalDevice(), pending.get(), nullptr);
+    } catch (const std::exception&) {
+      // failed variant was never used, there is nothing to destroy
+    }
+  }
+  for (auto& [pipeline, selection] : _retired) vkDestroyPipeline(_device->getLogicalDevice(), pipeline, nullptr);
   vkDestroyPipelineLayout(_device->getLogicalDevice(), _pipelineLayout, nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "Query.h"
+#include <algorithm>
+
+QueryPool::QueryPool(int number, std::shared_ptr<Device> device) {
+  _device = device;
+  _number = number;
+
+  VkQueryPoolCreateInfo queryPoolInfo{};
+  queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  queryPoolInfo.queryCount = static_cast<uint32_t>(number);
+
+  // the same pool is written from graphic and compute queues, the fewest valid bits of them keeps difference of both
+  // right as long as it's shorter than the smaller period
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(device->getPhysicalDevice(), &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(device->getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+  uint32_t validBits = 64;
+  for (auto family : {device->getSupportedGraphicsFamilyIndex(), device->getSupportedComputeFamilyIndex()}) {
+    // 0 means the queue doesn't support timestamps, nothing is written from it
+    if (family.has_value() && queueFamilies[family.value()].timestampValidBits > 0)
+      validBits = std::min(validBits, queueFamilies[family.value()].timestampValidBits);
+  }
+  if (validBits < 64) _validMask = (1ull << validBits) - 1;
+
+  if (vkCreateQueryPool(device->getLogicalDevice(), &queryPoolInfo, nullptr, &_queryPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create query pool!");
+  }
+}
+
+std::optional<std::vector<uint64_t>> QueryPool::getResults(int first, int count, bool wait) {
+  std::vector<uint64_t> results(count);
+  VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT;
+  if (wait) flags |= VK_QUERY_RESULT_WAIT_BIT;
+
+  auto result = vkGetQueryPoolResults(_device->getLogicalDevice(), _queryPool, first, count,
+                                      results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t), flags);
+  if (result != VK_SUCCESS) return std::nullopt;
+
+  return results;
+}
+
+float QueryPool::getElapsed(uint64_t begin, uint64_t end) {
+  // difference modulo the counter range is right even if the counter wrapped around between the timestamps
+  uint64_t ticks = ((end & _validMask) - (begin & _validMask)) & _validMask;
+  // timestampPeriod is number of nanoseconds per tick
+  return ticks * _device->getDeviceProperties().limits.timestampPeriod / 1000000.f;
+}
+
+void QueryPool::resetFrame(VkCommandBuffer commandBuffer, int currentFrame, int count) {
+  vkCmdResetQueryPool(commandBuffer, _queryPool, currentFrame * count, count);
+  if (static_cast<int>(_frameWritten.size()) <= currentFrame) _frameWritten.resize(currentFrame + 1, false);
+  _frameWritten[currentFrame] = true;
+}
+
+std::optional<std::vector<float>> QueryPool::getFrameTimes(int currentFrame, int count) {
+  if (static_cast<int>(_frameWritten.size()) <= currentFrame || _frameWritten[currentFrame] == false)
+    return std::nullopt;
+  // caller has waited the fence of the frame slot, so the previous frame's timestamps are ready and reading doesn't
+  // stall; without wait flag a broken frame gives no times instead of blocking
+  auto timestamps = getResults(currentFrame * count, count, false);
+  if (timestamps.has_value() == false) return std::nullopt;
+
+  std::vector<float> times;
+  for (int i = 1; i < count; i++) times.push_back(getElapsed(timestamps.value()[i - 1], timestamps.value()[i]));
+  return times;
+}
+
+VkQueryPool& QueryPool::getQueryPool() { return _queryPool; }
+
+QueryPool::~QueryPool() { vkDestroyQueryPool(_device->getLogicalDevice(), _queryPool, nullptr); }
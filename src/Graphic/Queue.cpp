@@ -1,10 +1,24 @@
 #include "Queue.h"
 
-Queue::Queue(std::shared_ptr<Device> device) {
-  vkGetDeviceQueue(device->getLogicalDevice(), device->getSupportedGraphicsFamilyIndex().value(), 0, &_graphicQueue);
-  vkGetDeviceQueue(device->getLogicalDevice(), device->getSupportedPresentFamilyIndex().value(), 0, &_presentQueue);
+Queue::Queue(std::shared_ptr<Device> device, bool asyncCompute) {
+  _graphicFamily = device->getSupportedGraphicsFamilyIndex().value();
+  vkGetDeviceQueue(device->getLogicalDevice(), _graphicFamily, 0, &_graphicQueue);
+  // surfaceless device has no present family, nothing is presented
+  _presentQueue = _graphicQueue;
+  if (device->getSupportedPresentFamilyIndex().has_value())
+    vkGetDeviceQueue(device->getLogicalDevice(), device->getSupportedPresentFamilyIndex().value(), 0, &_presentQueue);
+  _computeFamily = asyncCompute ? device->getSupportedComputeFamilyIndex().value() : _graphicFamily;
+  vkGetDeviceQueue(device->getLogicalDevice(), _computeFamily, 0, &_computeQueue);
 }
 
 VkQueue& Queue::getGraphicQueue() { return _graphicQueue; }
 
 VkQueue& Queue::getPresentQueue() { return _presentQueue; }
+
+VkQueue& Queue::getComputeQueue() { return _computeQueue; }
+
+uint32_t Queue::getGraphicFamilyIndex() { return _graphicFamily; }
+
+uint32_t Queue::getComputeFamilyIndex() { return _computeFamily; }
+
+bool Queue::isAsyncCompute() { return _computeFamily != _graphicFamily; }
@@ -55,6 +55,9 @@ Swapchain::Swapchain(std::shared_ptr<Window> window, std::shared_ptr<Surface> su
   createInfo.imageExtent = extent;
   createInfo.imageArrayLayers = 1;
   createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  // allows to blit rendered image directly to swapchain image, bypassing the sprite draw
+  if (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+    createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
   uint32_t queueFamilyIndices[] = {device->getSupportedGraphicsFamilyIndex().value(),
                                    device->getSupportedPresentFamilyIndex().value()};
@@ -83,6 +86,7 @@ Swapchain::Swapchain(std::shared_ptr<Window> window, std::shared_ptr<Surface> su
 
   _swapchainImageFormat = surfaceFormat.format;
   _swapchainExtent = extent;
+  _imageUsage = createInfo.imageUsage;
 
   _swapchainImageViews.resize(_swapchainImages.size());
 
@@ -113,4 +117,6 @@ VkSwapchainKHR& Swapchain::getSwapchain() { return _swapchain; }
 
 VkExtent2D& Swapchain::getSwapchainExtent() { return _swapchainExtent; }
 
+VkImageUsageFlags Swapchain::getImageUsage() { return _imageUsage; }
+
 Swapchain::~Swapchain() { vkDestroySwapchainKHR(_device->getLogicalDevice(), _swapchain, nullptr); }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "CapturePart.h"
+#include "ImageEncoder.h"
+#include <glm/gtc/packing.hpp>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+CapturePart::CapturePart(std::shared_ptr<Device> device,
+                         std::shared_ptr<Queue> queue,
+                         std::shared_ptr<CommandPool> commandPool,
+                         std::shared_ptr<Settings> settings,
+                         int slots) {
+  _device = device;
+  _queue = queue;
+  _settings = settings;
+  _commandBuffer = std::make_shared<CommandBuffer>(slots, commandPool, device);
+
+  auto [width, height] = settings->getResolution();
+  // texels are half float RGBA like in result textures of the parts
+  VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 8;
+  for (int i = 0; i < slots; i++) {
+    auto buffer = std::make_shared<Buffer>(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                           device);
+    buffer->map();
+    _stagingBuffers.push_back(buffer);
+    // created signaled, so a free slot doesn't need special case
+    _fences.push_back(std::make_shared<Fence>(device));
+    // slots are encoded in parallel already, so every one compresses its bands on own thread
+    _encoders.push_back(std::make_shared<ImageEncoder>());
+    _pixels.push_back(std::vector<glm::vec4>(width * height));
+  }
+  _jobs.resize(slots);
+  _states.resize(slots, SlotState::FREE);
+  _extents.resize(slots);
+  _numbers.resize(slots);
+
+  _checkboxes["capture"] = &_enabled;
+}
+
+void CapturePart::_encode(int slot) {
+  auto [width, height] = _extents[slot];
+  auto texels = static_cast<uint64_t*>(_stagingBuffers[slot]->getMappedMemory());
+  auto& pixels = _pixels[slot];
+  pixels.resize(width * height);
+  for (int i = 0; i < pixels.size(); i++) {
+    pixels[i] = glm::unpackHalf4x16(texels[i]);
+    if (_decodeGamma) {
+      for (int channel = 0; channel < 3; channel++) {
+        float value = pixels[i][channel];
+        pixels[i][channel] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+      }
+    }
+  }
+
+  std::stringstream path;
+  auto dot = _path.find_last_of('.');
+  path << _path.substr(0, dot) << "_" << std::setw(5) << std::setfill('0') << _numbers[slot]
+       << (dot == std::string::npos ? ".png" : _path.substr(dot));
+  _encoders[slot]->save(path.str(), pixels, _extents[slot]);
+}
+
+void CapturePart::_collect() {
+  for (int slot = 0; slot < _states.size(); slot++) {
+    if (_states[slot] == SlotState::COPYING &&
+        vkGetFenceStatus(_device->getLogicalDevice(), _fences[slot]->getFence()) == VK_SUCCESS) {
+      _jobs[slot] = std::async(std::launch::async, &CapturePart::_encode, this, slot);
+      _states[slot] = SlotState::ENCODING;
+    }
+    if (_states[slot] == SlotState::ENCODING &&
+        _jobs[slot].wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      // rethrows errors of the encoder, e.g. file can't be written
+      _jobs[slot].get();
+      _states[slot] = SlotState::FREE;
+    }
+  }
+}
+
+bool CapturePart::capture(std::shared_ptr<Texture> texture, std::tuple<int, int> extent, VkSemaphore finished) {
+  _collect();
+  if (_enabled == false) return false;
+  // slots are used in order, so frames are encoded in the order they were captured
+  int slot = _next;
+  if (_states[slot] != SlotState::FREE) {
+    _dropped++;
+    return false;
+  }
+
+  auto [width, height] = extent;
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[slot];
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    throw std::runtime_error("failed to begin recording capture command buffer!");
+
+  // the frame which wrote the texture is submitted earlier to the same queue; with async compute the texture is
+  // written on compute queue and acquired by the frame's graphic submit for transfer reads, transfer stage chains to it
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+  vkCmdCopyImageToBuffer(commandBuffer, texture->getImageView()->getImage()->getImage(), VK_IMAGE_LAYOUT_GENERAL,
+                         _stagingBuffers[slot]->getData(), 1, &region);
+  memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    throw std::runtime_error("failed to record capture command buffer!");
+
+  auto result = vkResetFences(_device->getLogicalDevice(), 1, &_fences[slot]->getFence());
+  if (result != VK_SUCCESS) throw std::runtime_error("Can't reset fence");
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &commandBuffer;
+  // later frames overwrite the texture, possibly on compute queue, their writes must wait for the copy
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &finished;
+  if (vkQueueSubmit(_queue->getGraphicQueue(), 1, &submitInfo, _fences[slot]->getFence()) != VK_SUCCESS)
+    throw std::runtime_error("failed to submit capture command buffer!");
+
+  _extents[slot] = extent;
+  _numbers[slot] = _captured++;
+  _states[slot] = SlotState::COPYING;
+  _next = (slot + 1) % _states.size();
+  return true;
+}
+
+void CapturePart::flush() {
+  for (int slot = 0; slot < _states.size(); slot++) {
+    if (_states[slot] == SlotState::COPYING) {
+      vkWaitForFences(_device->getLogicalDevice(), 1, &_fences[slot]->getFence(), VK_TRUE, UINT64_MAX);
+      _encode(slot);
+    }
+    if (_states[slot] == SlotState::ENCODING) _jobs[slot].get();
+    _states[slot] = SlotState::FREE;
+  }
+  if (_captured > 0) std::cout << "capture: " << _captured << " frames, " << _dropped << " dropped" << std::endl;
+}
+
+void CapturePart::setPath(std::string path) { _path = path; }
+
+void CapturePart::setEnabled(bool enabled) { _enabled = enabled; }
+
+void CapturePart::setDecodeGamma(bool decodeGamma) { _decodeGamma = decodeGamma; }
+
+std::map<std::string, bool*> CapturePart::getCheckboxes() { return _checkboxes; }
+
+int CapturePart::getCaptured() { return _captured; }
+
+int CapturePart::getDropped() { return _dropped; }
+
+CapturePart::~CapturePart() {
+  // errors are reported by flush, here only threads using the buffers are waited
+  for (auto& job : _jobs)
+    if (job.valid()) job.wait();
+}
\ No newline at end of file
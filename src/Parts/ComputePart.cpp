@@ -1,171 +1,94 @@
 #include "ComputePart.h"
 #include "Input.h"
+#include "Query.h"
+#include "Sobol.h"
 #include <random>
-
-struct UniformCamera {
-  float fov;
-  alignas(16) glm::vec3 origin;
-  alignas(16) glm::mat4 camera;
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+struct PushConstants {
+  int width;
+  int height;
+  uint32_t frameIndex;
+  float cacheCellSize;
+  int cacheMinSamples;
+  float guideCellSize;
+  float guideFraction;
+  int guideMinSamples;
+  int rows;
 };
 
-enum MaterialType { MATERIAL_DIFFUSE = 0, MATERIAL_METAL = 1, MATERIAL_DIELECTRIC = 2 };
-
-struct UniformMaterial {
-  int type;
-  alignas(16) glm::vec3 attenuation;
-  // actual only for metal
-  float fuzz;
-  // actual only for dielectric (etaIn / etaOut)
-  float refraction;
+// matches std430 layout of CacheCell in raytracing.comp and cache.comp
+struct CacheCell {
+  uint32_t checksum;
+  uint32_t age;
+  uint32_t frameSamples;
+  uint32_t frameRed;
+  uint32_t frameGreen;
+  uint32_t frameBlue;
+  alignas(16) glm::vec4 radiance;
 };
 
-struct UniformSphere {
-  alignas(16) glm::vec3 center;
-  float radius;
-  int index;
-  UniformMaterial material;
+struct CacheParameters {
+  int maxAge;
+  int maxSamples;
+  int minSamples;
 };
 
-struct UniformSpheres {
-  int number;
-  UniformSphere spheres[300];
+struct CacheStatistics {
+  uint32_t occupiedCells;
+  uint32_t usableCells;
 };
 
-struct HitBoxTemp {
-  glm::vec3 center;
-  glm::vec3 bias;
-  int index;
-  int left;
-  int right;
-  int parent;
-  int sphere;
+// must be power of two
+constexpr int cacheCapacity = 1 << 18;
+
+// matches std430 layout of GuideCell in raytracing.comp and guiding.comp
+struct GuideCell {
+  uint32_t checksum;
+  uint32_t age;
+  uint32_t frameSamples;
+  uint32_t samples;
+  uint32_t train[64];
+  float density[64];
+  float cdf[64];
 };
 
-struct HitBox {
-  alignas(16) glm::vec3 min;
-  alignas(16) glm::vec3 max;
-  int next;
-  int exit;
-  int sphere;
+struct GuideParameters {
+  int maxAge;
+  float decay;
+  int minSamples;
 };
 
-struct UniformHitBox {
-  int number;
-  HitBox hitbox[300];
+struct GuideStatistics {
+  uint32_t occupiedCells;
+  uint32_t trainedCells;
 };
 
-struct UniformSettings {
-  int useBVH;
+// must be power of two, cell is much bigger than the radiance cache one
+constexpr int guideCapacity = 1 << 14;
+
+// rows are split between GPU and CPU in hybrid mode by bands of tile height of CPU tracer
+constexpr int bandRows = 16;
+
+struct SpecializationConstants {
+  int aaSamples;
+  int maxDepth;
+  VkBool32 useBVH;
+  int workgroupX;
+  int workgroupY;
+  VkBool32 useNEE;
+  VkBool32 useLightBVH;
+  VkBool32 useReSTIR;
+  VkBool32 useCache;
+  VkBool32 cacheDebug;
+  VkBool32 useGuiding;
 };
 
-HitBoxTemp mergeHitBoxes(std::vector<HitBoxTemp>& hitBox, int left, int right) {
-  auto leftHitBox = hitBox[left];
-  auto rightHitBox = hitBox[right];
-  HitBoxTemp result;
-  glm::vec3 minLeft = leftHitBox.center - leftHitBox.bias;
-  glm::vec3 maxLeft = leftHitBox.center + leftHitBox.bias;
-  glm::vec3 minRight = rightHitBox.center - rightHitBox.bias;
-  glm::vec3 maxRight = rightHitBox.center + rightHitBox.bias;
-
-  glm::vec3 minBoth = glm::vec3(std::min(minLeft.x, minRight.x), std::min(minLeft.y, minRight.y),
-                                std::min(minLeft.z, minRight.z));
-  glm::vec3 maxBoth = glm::vec3(std::max(maxLeft.x, maxRight.x), std::max(maxLeft.y, maxRight.y),
-                                std::max(maxLeft.z, maxRight.z));
-
-  result.center = (minBoth + maxBoth) / 2.f;
-  result.bias = result.center - minBoth;
-  return result;
-}
-
-void calculateThreadedBVH(std::vector<HitBoxTemp> hitBox, UniformHitBox& hitBoxResult) {
-  hitBoxResult.hitbox[0].next = hitBox[1].index;
-  hitBoxResult.hitbox[0].exit = -1;
-  hitBoxResult.hitbox[0].min = hitBox[0].center - hitBox[0].bias;
-  hitBoxResult.hitbox[0].max = hitBox[0].center + hitBox[0].bias;
-  hitBoxResult.hitbox[0].sphere = hitBox[0].sphere;
-
-  for (int i = 1; i < hitBox.size() - 1; i++) {
-    hitBoxResult.hitbox[i].next = hitBox[i + 1].index;
-    hitBoxResult.hitbox[i].exit = -1;
-    hitBoxResult.hitbox[i].min = hitBox[i].center - hitBox[i].bias;
-    hitBoxResult.hitbox[i].max = hitBox[i].center + hitBox[i].bias;
-    hitBoxResult.hitbox[i].sphere = hitBox[i].sphere;
-
-    if (hitBox[i].left == -1 && hitBox[i].right == -1) {
-      hitBoxResult.hitbox[i].exit = hitBoxResult.hitbox[i].next;
-    } else {
-      auto parentNode = hitBox[hitBox[i].parent];
-      if (parentNode.left == hitBox[i].index) {
-        // left
-        // internal
-        hitBoxResult.hitbox[i].exit = parentNode.right;
-      } else {
-        // right
-        // internal
-
-        // check if parent exist and it's not right child
-        while (parentNode.parent != -1) {
-          auto grandparentNode = hitBox[parentNode.parent];
-          if (grandparentNode.right != parentNode.index) {
-            hitBoxResult.hitbox[i].exit = grandparentNode.right;
-            break;
-          }
-          parentNode = grandparentNode;
-        }
-      }
-    }
-  }
-
-  hitBoxResult.hitbox[hitBox.size() - 1].next = -1;
-  hitBoxResult.hitbox[hitBox.size() - 1].exit = -1;
-  hitBoxResult.hitbox[hitBox.size() - 1].min = hitBox[hitBox.size() - 1].center - hitBox[hitBox.size() - 1].bias;
-  hitBoxResult.hitbox[hitBox.size() - 1].max = hitBox[hitBox.size() - 1].center + hitBox[hitBox.size() - 1].bias;
-  hitBoxResult.hitbox[hitBox.size() - 1].sphere = hitBox[hitBox.size() - 1].sphere;
-}
-
-int calculateHitbox(std::vector<UniformSphere> spheres, std::vector<HitBoxTemp>& hitBox, int parent) {
-  HitBoxTemp current;
-  int index = hitBox.size();
-  hitBox.push_back(current);
-
-  if (spheres.size() == 1) {
-    hitBox[index].center = spheres[0].center;
-    hitBox[index].bias = glm::vec3(spheres[0].radius, spheres[0].radius, spheres[0].radius);
-    hitBox[index].left = -1;
-    hitBox[index].right = -1;
-    hitBox[index].sphere = spheres[0].index;
-  } else {
-    int axis = rand() % 3;
-    if (axis == 0) {
-      std::sort(spheres.begin(), spheres.end(), [](UniformSphere& left, UniformSphere& right) {
-        return (left.center - left.radius).x < (right.center - right.radius).x;
-      });
-    } else if (axis == 1) {
-      std::sort(spheres.begin(), spheres.end(), [](UniformSphere& left, UniformSphere& right) {
-        return (left.center - left.radius).y < (right.center - right.radius).y;
-      });
-    } else {
-      std::sort(spheres.begin(), spheres.end(), [](UniformSphere& left, UniformSphere& right) {
-        return (left.center - left.radius).z < (right.center - right.radius).z;
-      });
-    }
-
-    int mid = spheres.size() / 2;
-    auto left = calculateHitbox(std::vector<UniformSphere>(spheres.begin(), spheres.begin() + mid), hitBox, index);
-    auto right = calculateHitbox(std::vector<UniformSphere>(spheres.begin() + mid, spheres.end()), hitBox, index);
-    hitBox[index] = mergeHitBoxes(hitBox, left, right);
-    hitBox[index].left = left;
-    hitBox[index].right = right;
-    hitBox[index].sphere = -1;
-  }
-
-  hitBox[index].index = index;
-  hitBox[index].parent = parent;
-
-  return index;
-}
-
-ComputePart::ComputePart(std::shared_ptr<Device> device,
+ComputePart::ComputePart(std::shared_ptr<Scene> scene,
+                         std::shared_ptr<Device> device,
                          std::shared_ptr<Queue> queue,
                          std::shared_ptr<CommandBuffer> commandBuffer,
                          std::shared_ptr<CommandPool> commandPool,
@@ -175,16 +98,24 @@ ComputePart::ComputePart(std::shared_ptr<Device> device,
   _commandBuffer = commandBuffer;
   _commandPool = commandPool;
   _settings = settings;
+  _scene = scene;
+
+  auto createTexture = [&](VkFormat format, VkImageUsageFlags usage) {
+    return std::make_shared<Texture>(settings->getResolution(), format, usage, commandPool, queue, device);
+  };
 
   for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
-    // Image will be sampled in the fragment shader and used as storage target in the compute shader
-    std::shared_ptr<Image> image = std::make_shared<Image>(
-        settings->getResolution(), VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device);
-    image->changeLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, commandPool, queue);
-    std::shared_ptr<ImageView> imageView = std::make_shared<ImageView>(image, VK_IMAGE_ASPECT_COLOR_BIT, device);
-    std::shared_ptr<Texture> texture = std::make_shared<Texture>(imageView, device);
-    _resultTextures.push_back(texture);
+    // Image is used as storage target in the compute shader and accumulated by TemporalPart,
+    // float format keeps precision for accumulation and filter passes, in hybrid mode CPU rows are copied in,
+    // in headless mode it's copied out
+    _resultTextures.push_back(createTexture(
+        VK_FORMAT_R16G16B16A16_SFLOAT,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+    // guide buffers are only read by denoiser
+    _albedoTextures.push_back(
+        createTexture(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+    _normalDepthTextures.push_back(createTexture(VK_FORMAT_R16G16B16A16_SFLOAT,
+                                                 VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
   }
 
   _descriptorSetLayout = std::make_shared<DescriptorSetLayout>(device);
@@ -193,7 +124,6 @@ ComputePart::ComputePart(std::shared_ptr<Device> device,
   _shader = std::make_shared<Shader>(device);
   _shader->add("../shaders/raytracing.spv", VK_SHADER_STAGE_COMPUTE_BIT);
   _pipeline = std::make_shared<Pipeline>(_shader, _descriptorSetLayout, device);
-  _pipeline->createCompute();
 
   _descriptorPool = std::make_shared<DescriptorPool>(100, device);
   _descriptorSet = std::make_shared<DescriptorSet>(settings->getMaxFramesInFlight(), _descriptorSetLayout,
@@ -204,134 +134,14 @@ ComputePart::ComputePart(std::shared_ptr<Device> device,
                                                           commandPool, queue, device);
   _uniformBufferHitboxes = std::make_shared<UniformBuffer>(settings->getMaxFramesInFlight(), sizeof(UniformHitBox),
                                                            commandPool, queue, device);
-  _uniformBufferSettings = std::make_shared<UniformBuffer>(settings->getMaxFramesInFlight(), sizeof(UniformSettings),
-                                                           commandPool, queue, device);
-  std::random_device rd;
-  std::mt19937 e2(rd());
-  std::uniform_real_distribution<> dist(0, 1);
-  std::uniform_real_distribution<> dist2(0, 0.5);
-  std::uniform_real_distribution<> dist3(0.5, 1);
-
-  UniformSpheres spheres;
-  int current = 0;
-  {
-    UniformSphere sphere{};
-    sphere.center = glm::vec3(0.f, -1000.f, 0.f);
-    sphere.radius = 1000.f;
-    sphere.index = current;
-    UniformMaterial material{};
-    material.type = MATERIAL_DIFFUSE;
-    material.attenuation = glm::vec3(0.5, 0.5, 0.5);
-    material.fuzz = 0;
-    material.refraction = 1;
-    sphere.material = material;
-    spheres.spheres[current++] = sphere;
-  }
-  for (int a = -4; a < 4; a++) {
-    for (int b = -4; b < 4; b++) {
-      float chooseMat = dist(e2);
-      glm::vec3 center(a + 0.9 * dist(e2), 0.2, b + 0.9 * dist(e2));
-
-      if ((center - glm::vec3(4, 0.2, 0)).length() > 0.9) {
-        if (chooseMat < 0.8) {
-          // diffuse
-          auto albedo = glm::vec3(dist(e2), dist(e2), dist(e2));
-          {
-            UniformSphere sphere{};
-            sphere.center = center;
-            sphere.radius = 0.2;
-            sphere.index = current;
-            UniformMaterial material{};
-            material.type = MATERIAL_DIFFUSE;
-            material.attenuation = albedo;
-            material.fuzz = 0;
-            material.refraction = 1;
-            sphere.material = material;
-            spheres.spheres[current++] = sphere;
-          }
-        } else if (chooseMat < 0.95) {
-          // metal
-          auto albedo = glm::vec3(dist3(e2), dist3(e2), dist3(e2));
-          auto fuzz = dist2(e2);
-          {
-            UniformSphere sphere{};
-            sphere.center = center;
-            sphere.radius = 0.2;
-            sphere.index = current;
-            UniformMaterial material{};
-            material.type = MATERIAL_METAL;
-            material.attenuation = albedo;
-            material.fuzz = fuzz;
-            material.refraction = 1;
-            sphere.material = material;
-            spheres.spheres[current++] = sphere;
-          }
-        } else {
-          // glass
-          {
-            UniformSphere sphere{};
-            sphere.center = center;
-            sphere.radius = 0.2;
-            sphere.index = current;
-            UniformMaterial material{};
-            material.type = MATERIAL_DIELECTRIC;
-            material.attenuation = glm::vec3(1.f, 1.f, 1.f);
-            material.fuzz = 0;
-            material.refraction = 1.f / 1.5f;
-            sphere.material = material;
-            spheres.spheres[current++] = sphere;
-          }
-        }
-      }
-    }
-  }
-  {
-    UniformSphere sphere{};
-    sphere.center = glm::vec3(0, 1, 0);
-    sphere.radius = 1.0;
-    sphere.index = current;
-    UniformMaterial material{};
-    material.type = MATERIAL_DIELECTRIC;
-    material.attenuation = glm::vec3(1.f, 1.f, 1.f);
-    material.fuzz = 0;
-    material.refraction = 1.f / 1.5f;
-    sphere.material = material;
-    spheres.spheres[current++] = sphere;
-  }
-  {
-    UniformSphere sphere{};
-    sphere.center = glm::vec3(-4, 1, 0);
-    sphere.radius = 1.0;
-    sphere.index = current;
-    UniformMaterial material{};
-    material.type = MATERIAL_DIFFUSE;
-    material.attenuation = glm::vec3(0.4f, 0.2f, 0.1f);
-    material.fuzz = 0;
-    material.refraction = 1.f;
-    sphere.material = material;
-    spheres.spheres[current++] = sphere;
-  }
-  {
-    UniformSphere sphere{};
-    sphere.center = glm::vec3(4, 1, 0);
-    sphere.radius = 1.0;
-    sphere.index = current;
-    UniformMaterial material{};
-    material.type = MATERIAL_METAL;
-    material.attenuation = glm::vec3(0.7f, 0.6f, 0.5f);
-    material.fuzz = 0;
-    material.refraction = 1.f;
-    sphere.material = material;
-    spheres.spheres[current++] = sphere;
-  }
-
-  spheres.number = current;
-
-  UniformHitBox hitboxes;
-  std::vector<HitBoxTemp> hitboxTemp;
-  calculateHitbox(std::vector<UniformSphere>(spheres.spheres, spheres.spheres + spheres.number), hitboxTemp, -1);
-  hitboxes.number = hitboxTemp.size();
-  calculateThreadedBVH(hitboxTemp, hitboxes);
+  auto& spheres = _scene->getSpheres();
+  auto& lights = _scene->getLights();
+  auto& lightTree = _scene->getLightTree();
+  auto& hitboxes = _scene->getHitboxes();
+  _storageBufferLights = std::make_shared<StorageBuffer>(lights.size() * sizeof(int), lights.data(), commandPool,
+                                                         queue, device);
+  _storageBufferLightTree = std::make_shared<StorageBuffer>(lightTree.size() * sizeof(LightNode), lightTree.data(),
+                                                            commandPool, queue, device);
   for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
     void* data;
     vkMapMemory(_device->getLogicalDevice(), _uniformBufferSpheres->getBuffer()[i]->getMemory(), 0, sizeof(spheres), 0,
@@ -348,20 +158,238 @@ ComputePart::ComputePart(std::shared_ptr<Device> device,
     vkUnmapMemory(_device->getLogicalDevice(), _uniformBufferHitboxes->getBuffer()[i]->getMemory());
   }
 
+  // pixel jitter and every bounce use 4 dimensions, sets are decorrelated by scrambling in shader
+  Sobol sobol(4096, 4);
+  _storageBufferSobol = std::make_shared<StorageBuffer>(sobol.getTable().size() * sizeof(uint32_t),
+                                                        sobol.getTable().data(), commandPool, queue, device);
+
+  // empty cells have zero checksum
+  _storageBufferCache = std::make_shared<StorageBuffer>(cacheCapacity * sizeof(CacheCell), nullptr, commandPool,
+                                                        queue, device);
+  _cacheStatistics = _createHashGridStatistics(sizeof(CacheStatistics));
+  _cacheDescriptorSetLayout = std::make_shared<DescriptorSetLayout>(device);
+  _cacheDescriptorSetLayout->createCache();
+  _cacheDescriptorSet = std::make_shared<DescriptorSet>(settings->getMaxFramesInFlight(), _cacheDescriptorSetLayout,
+                                                        _descriptorPool, device);
+  _cacheDescriptorSet->createCache(_storageBufferCache, _cacheStatistics);
+  _cacheShader = std::make_shared<Shader>(device);
+  _cacheShader->add("../shaders/cache.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _cachePipeline = std::make_shared<Pipeline>(_cacheShader, _cacheDescriptorSetLayout, device);
+  VkPushConstantRange cachePushConstant{};
+  cachePushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  cachePushConstant.offset = 0;
+  cachePushConstant.size = sizeof(CacheParameters);
+  _cachePipeline->createCompute(nullptr, {cachePushConstant});
+
+  // the same descriptor layout as the radiance cache: cells and per frame statistics
+  _storageBufferGuide = std::make_shared<StorageBuffer>(guideCapacity * sizeof(GuideCell), nullptr, commandPool,
+                                                        queue, device);
+  _guideStatistics = _createHashGridStatistics(sizeof(GuideStatistics));
+  _guideDescriptorSet = std::make_shared<DescriptorSet>(settings->getMaxFramesInFlight(), _cacheDescriptorSetLayout,
+                                                        _descriptorPool, device);
+  _guideDescriptorSet->createCache(_storageBufferGuide, _guideStatistics);
+  _guideShader = std::make_shared<Shader>(device);
+  _guideShader->add("../shaders/guiding.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _guidePipeline = std::make_shared<Pipeline>(_guideShader, _cacheDescriptorSetLayout, device);
+  VkPushConstantRange guidePushConstant{};
+  guidePushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  guidePushConstant.offset = 0;
+  guidePushConstant.size = sizeof(GuideParameters);
+  _guidePipeline->createCompute(nullptr, {guidePushConstant});
+
   _descriptorSet->createCompute(_resultTextures, _uniformBuffer, _uniformBufferSpheres, _uniformBufferHitboxes,
-                                _uniformBufferSettings);
+                                _storageBufferSobol, _albedoTextures, _normalDepthTextures, _storageBufferLights,
+                                _storageBufferLightTree, _storageBufferCache, _storageBufferGuide);
+
+  _checkboxes["use_bvh"] = &_useBVH;
+  _checkboxes["use_nee"] = &_useNEE;
+  _checkboxes["use_light_bvh"] = &_useLightBVH;
+  _sliders["aa_samples"] = {&_aaSamples, 1, 100};
+  _sliders["max_depth"] = {&_maxDepth, 1, 50};
+  _checkboxes["dynamic_resolution"] = &_dynamicResolution;
+  _slidersFloat["target_ms"] = {&_targetTime, 1.f, 100.f};
+  _checkboxes["radiance_cache"] = &_useCache;
+  _checkboxes["radiance_cache_debug"] = &_cacheDebug;
+  _slidersFloat["cache_cell_size"] = {&_cacheCellSize, 0.01f, 1.f};
+  _sliders["cache_min_samples"] = {&_cacheMinSamples, 1, 256};
+  _sliders["cache_max_age"] = {&_cacheMaxAge, 1, 300};
+  _checkboxes["path_guiding"] = &_useGuiding;
+  _slidersFloat["guide_cell_size"] = {&_guideCellSize, 0.05f, 2.f};
+  _slidersFloat["guide_fraction"] = {&_guideFraction, 0.f, 0.9f};
+  _sliders["guide_min_samples"] = {&_guideMinSamples, 1, 1024};
+  _sliders["guide_max_age"] = {&_guideMaxAge, 1, 600};
+  _slidersFloat["guide_decay"] = {&_guideDecay, 0.5f, 1.f};
+  _extent = settings->getResolution();
+  _rows = std::get<1>(_extent);
+  // begin and end timestamps of ray tracing for every frame in flight
+  _queryPool = std::make_shared<QueryPool>(2 * settings->getMaxFramesInFlight(), device);
+  // compile default variant upfront
+  _selectVariant();
+}
 
-  _checkboxes["use_bvh"] = new bool();
+void ComputePart::_selectVariant(bool async) {
+  SpecializationConstants constants{};
+  constants.aaSamples = _aaSamples;
+  constants.maxDepth = _maxDepth;
+  constants.useBVH = _useBVH;
+  constants.workgroupX = _workgroupSize[0];
+  constants.workgroupY = _workgroupSize[1];
+  constants.useNEE = _useNEE;
+  constants.useLightBVH = _useLightBVH;
+  constants.useReSTIR = _useReSTIR;
+  constants.useCache = _useCache;
+  constants.cacheDebug = _cacheDebug;
+  constants.useGuiding = _useGuiding;
+
+  std::array<VkSpecializationMapEntry, 11> entries{};
+  entries[0] = {0, offsetof(SpecializationConstants, aaSamples), sizeof(int)};
+  entries[1] = {1, offsetof(SpecializationConstants, maxDepth), sizeof(int)};
+  entries[2] = {2, offsetof(SpecializationConstants, useBVH), sizeof(VkBool32)};
+  entries[3] = {3, offsetof(SpecializationConstants, workgroupX), sizeof(int)};
+  entries[4] = {4, offsetof(SpecializationConstants, workgroupY), sizeof(int)};
+  entries[5] = {5, offsetof(SpecializationConstants, useNEE), sizeof(VkBool32)};
+  entries[6] = {6, offsetof(SpecializationConstants, useLightBVH), sizeof(VkBool32)};
+  entries[7] = {7, offsetof(SpecializationConstants, useReSTIR), sizeof(VkBool32)};
+  entries[8] = {8, offsetof(SpecializationConstants, useCache), sizeof(VkBool32)};
+  entries[9] = {9, offsetof(SpecializationConstants, cacheDebug), sizeof(VkBool32)};
+  entries[10] = {10, offsetof(SpecializationConstants, useGuiding), sizeof(VkBool32)};
+
+  VkSpecializationInfo specializationInfo{};
+  specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+  specializationInfo.pMapEntries = entries.data();
+  specializationInfo.dataSize = sizeof(constants);
+  specializationInfo.pData = &constants;
+  // every variant is compiled only once while it's kept, switching back and forth is just a lookup
+  VkPushConstantRange pushConstant{};
+  pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstant.offset = 0;
+  pushConstant.size = sizeof(PushConstants);
+  if (async)
+    _pipeline->selectCompute(&specializationInfo, {pushConstant});
+  else
+    _pipeline->createCompute(&specializationInfo, {pushConstant});
 }
 
 std::map<std::string, bool*> ComputePart::getCheckboxes() { return _checkboxes; }
 
+std::map<std::string, std::tuple<int*, int, int>> ComputePart::getSliders() { return _sliders; }
+
 glm::vec3 from = glm::vec3(0, 2, 3);
 glm::vec3 up = glm::vec3(0, 1, 0);
 float cameraSpeed = 0.05f;
 float deltaTime = 0.f;
 float lastFrame = 0.f;
 float fov = 90;
+void ComputePart::_updateCamera(int currentFrame) {
+  _camera = createCamera(from, Input::direction, up, fov);
+  void* data;
+  vkMapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory(), 0,
+              sizeof(_camera), 0, &data);
+  memcpy(data, &_camera, sizeof(_camera));
+  vkUnmapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory());
+}
+
+void ComputePart::_dispatch(VkCommandBuffer commandBuffer, int currentFrame) {
+  _selectVariant(true);
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipeline());
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipelineLayout(), 0, 1,
+                          &_descriptorSet->getDescriptorSets()[currentFrame], 0, 0);
+  auto [width, height] = _extent;
+  PushConstants pushConstants{width,          height,         _frameIndex,       _cacheCellSize, _cacheMinSamples,
+                              _guideCellSize, _guideFraction, _guideMinSamples, _rows};
+  vkCmdPushConstants(commandBuffer, _pipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(PushConstants), &pushConstants);
+  // round up so resolution doesn't have to be multiple of workgroup size, shader skips invocations outside of image
+  vkCmdDispatch(commandBuffer, (width + _workgroupSize[0] - 1) / _workgroupSize[0],
+                (_rows + _workgroupSize[1] - 1) / _workgroupSize[1], 1);
+}
+
+void ComputePart::autotune(std::string path, bool force) {
+  // pipelineCacheUUID identifies both device and driver version, best shape depends on both
+  std::stringstream uuid;
+  for (auto byte : _device->getDeviceProperties().pipelineCacheUUID)
+    uuid << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+
+  std::map<std::string, std::array<int, 2>> cache;
+  {
+    std::ifstream file(path);
+    std::string key;
+    std::array<int, 2> size;
+    while (file >> key >> size[0] >> size[1]) cache[key] = size;
+  }
+
+  if (cache.contains(uuid.str()) && force == false) {
+    _workgroupSize = cache[uuid.str()];
+    _selectVariant();
+    return;
+  }
+  // without autotune mode default shape is used
+  if (force == false) return;
+
+  auto& limits = _device->getDeviceProperties().limits;
+  if (limits.timestampComputeAndGraphics == VK_FALSE) {
+    std::cerr << "autotune: timestamps aren't supported, default workgroup size is used" << std::endl;
+    return;
+  }
+
+  // relative cost of shapes barely depends on sample count, so reduce it to keep startup time reasonable
+  int aaSamples = _aaSamples;
+  _aaSamples = std::min(_aaSamples, 16);
+  _updateCamera(0);
+
+  const int iterations = 3;
+  auto queryPool = std::make_shared<QueryPool>(2, _device);
+  std::vector<std::array<int, 2>> candidates = {{8, 8}, {16, 8}, {8, 16}, {16, 16}, {32, 4}, {32, 8}, {64, 4}};
+  std::array<int, 2> best = _workgroupSize;
+  float bestTime = std::numeric_limits<float>::max();
+  for (auto& candidate : candidates) {
+    if (candidate[0] * candidate[1] > limits.maxComputeWorkGroupInvocations ||
+        candidate[0] > limits.maxComputeWorkGroupSize[0] || candidate[1] > limits.maxComputeWorkGroupSize[1])
+      continue;
+
+    _workgroupSize = candidate;
+    // dispatch keeps the previous variant until the new one is ready, here the candidate has to be measured
+    _selectVariant();
+    auto commandBuffer = std::make_shared<CommandBuffer>(1, _commandPool, _device);
+    commandBuffer->beginSingleTimeCommands(0);
+    auto command = commandBuffer->getCommandBuffer()[0];
+    vkCmdResetQueryPool(command, queryPool->getQueryPool(), 0, 2);
+    // first dispatch is warm-up, bottom of pipe timestamp is written only after it's finished
+    for (int i = 0; i <= iterations; i++) {
+      if (i == 1)
+        vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool->getQueryPool(), 0);
+      _dispatch(command, 0);
+
+      VkMemoryBarrier memoryBarrier{};
+      memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                           &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool->getQueryPool(), 1);
+    commandBuffer->endSingleTimeCommands(0, _queue);
+
+    auto timestamps = queryPool->getResults(0, 2, true);
+    if (timestamps.has_value() == false) continue;
+    float time = queryPool->getElapsed(timestamps.value()[0], timestamps.value()[1]) / iterations;
+    std::cout << "autotune: workgroup " << candidate[0] << "x" << candidate[1] << " takes " << time << " ms"
+              << std::endl;
+    if (time < bestTime) {
+      bestTime = time;
+      best = candidate;
+    }
+  }
+
+  _aaSamples = aaSamples;
+  _workgroupSize = best;
+  _selectVariant();
+
+  cache[uuid.str()] = best;
+  std::ofstream file(path, std::ios::trunc);
+  for (auto& [key, size] : cache) file << key << " " << size[0] << " " << size[1] << std::endl;
+}
+
 void ComputePart::draw(int currentFrame) {
   float currentTime = static_cast<float>(glfwGetTime());
   deltaTime = currentTime - lastFrame;
@@ -375,36 +403,157 @@ void ComputePart::draw(int currentFrame) {
     from += deltaTime * up;
   }
 
-  {
-    void* data;
-    UniformSettings uboSettings{};
-    uboSettings.useBVH = *(_checkboxes["use_bvh"]);
-    vkMapMemory(_device->getLogicalDevice(), _uniformBufferSettings->getBuffer()[currentFrame]->getMemory(), 0,
-                sizeof(uboSettings), 0, &data);
-    memcpy(data, &uboSettings, sizeof(uboSettings));
-    vkUnmapMemory(_device->getLogicalDevice(), _uniformBufferSettings->getBuffer()[currentFrame]->getMemory());
+  _updateCamera(currentFrame);
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  // statistics buffers are written in the same frames as timestamps
+  if (auto times = _queryPool->getFrameTimes(currentFrame, 2)) {
+    _time = times.value()[0];
+    _updateScale();
+    auto statistics = static_cast<CacheStatistics*>(_cacheStatistics[currentFrame]->getMappedMemory());
+    _cacheOccupancy = static_cast<float>(statistics->occupiedCells) / cacheCapacity;
+    auto guideStatistics = static_cast<GuideStatistics*>(_guideStatistics[currentFrame]->getMappedMemory());
+    _guideOccupancy = static_cast<float>(guideStatistics->occupiedCells) / guideCapacity;
+  }
+  if (_dynamicResolution == false) _scale = 1.f;
+  auto [width, height] = _settings->getResolution();
+  _extent = {std::max(static_cast<int>(width * _scale), 1), std::max(static_cast<int>(height * _scale), 1)};
+  _rows = std::get<1>(_extent);
+  if (_gpuShare < 1.f && _rows > 2 * bandRows) {
+    // whole bands, both sides keep at least one, so time per row can be measured for both of them
+    int bands = static_cast<int>(std::round(_gpuShare * _rows / bandRows));
+    _rows = std::clamp(bands * bandRows, bandRows, (_rows - 1) / bandRows * bandRows);
   }
 
-  {
-    UniformCamera ubo{};
-    ubo.fov = glm::tan(glm::radians(fov) / 2.f);
-    ubo.camera = glm::transpose(glm::lookAt(from, from + Input::direction, up));
-    ubo.origin = from;
-    void* data;
-    vkMapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory(), 0, sizeof(ubo), 0,
-                &data);
-    memcpy(data, &ubo, sizeof(ubo));
-    vkUnmapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory());
+  _queryPool->resetFrame(commandBuffer, currentFrame, 2);
+  // previous frame reads guide buffers of this frame slot as history, wait for it before overwriting,
+  // radiance cache and guiding maintenance of the previous frame has to be visible
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * currentFrame);
+  _dispatch(commandBuffer, currentFrame);
+  // the time drives dynamic resolution and hybrid split, so it covers ray tracing only, not the grid maintenance
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * currentFrame + 1);
+  if (_useCache) {
+    CacheParameters cacheParameters{_cacheMaxAge, _cacheMaxSamples, _cacheMinSamples};
+    _updateHashGrid(commandBuffer, _cachePipeline, _cacheDescriptorSet->getDescriptorSets()[currentFrame],
+                    _cacheStatistics[currentFrame], cacheCapacity, &cacheParameters, sizeof(CacheParameters));
+  } else {
+    // nothing writes the counters of this slot, the fence is waited, so host clears them for the next read
+    memset(_cacheStatistics[currentFrame]->getMappedMemory(), 0, sizeof(CacheStatistics));
   }
+  if (_useGuiding) {
+    GuideParameters guideParameters{_guideMaxAge, _guideDecay, _guideMinSamples};
+    _updateHashGrid(commandBuffer, _guidePipeline, _guideDescriptorSet->getDescriptorSets()[currentFrame],
+                    _guideStatistics[currentFrame], guideCapacity, &guideParameters, sizeof(GuideParameters));
+  } else {
+    memset(_guideStatistics[currentFrame]->getMappedMemory(), 0, sizeof(GuideStatistics));
+  }
+  _frameIndex++;
+}
 
-  vkCmdBindDescriptorSets(_commandBuffer->getCommandBuffer()[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE,
-                          _pipeline->getPipelineLayout(), 0, 1, &_descriptorSet->getDescriptorSets()[currentFrame], 0,
-                          0);
-  vkCmdDispatch(_commandBuffer->getCommandBuffer()[currentFrame], std::get<0>(_settings->getResolution()) / 16,
-                std::get<1>(_settings->getResolution()) / 16, 1);
+void ComputePart::_updateHashGrid(VkCommandBuffer commandBuffer,
+                                  std::shared_ptr<Pipeline> pipeline,
+                                  VkDescriptorSet descriptorSet,
+                                  std::shared_ptr<Buffer> statistics,
+                                  int capacity,
+                                  const void* parameters,
+                                  uint32_t parametersSize) {
+  vkCmdFillBuffer(commandBuffer, statistics->getData(), 0, VK_WHOLE_SIZE, 0);
+  // samples of this frame are added by ray tracing with atomics
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getPipeline());
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getPipelineLayout(), 0, 1,
+                          &descriptorSet, 0, 0);
+  vkCmdPushConstants(commandBuffer, pipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, parametersSize,
+                     parameters);
+  // one invocation per cell
+  vkCmdDispatch(commandBuffer, (capacity + 63) / 64, 1, 1);
+
+  // counters are read on host after the fence of this frame slot
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+void ComputePart::_updateScale() {
+  if (_dynamicResolution == false || _time <= 0.f) return;
+  // cost is proportional to number of pixels, i.e. to square of scale
+  float desired = _scale * std::sqrt(_targetTime / _time);
+  // move only part of the way, measurement is from one frame and noisy
+  _scale = std::clamp(_scale + (desired - _scale) * 0.25f, 0.25f, 1.f);
+}
+
+std::vector<std::shared_ptr<Buffer>> ComputePart::_createHashGridStatistics(int size) {
+  std::vector<std::shared_ptr<Buffer>> statistics;
+  for (int i = 0; i < _settings->getMaxFramesInFlight(); i++) {
+    auto buffer = std::make_shared<Buffer>(
+        size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _device);
+    buffer->map();
+    memset(buffer->getMappedMemory(), 0, size);
+    statistics.push_back(buffer);
+  }
+  return statistics;
 }
 
+std::tuple<int, int> ComputePart::getExtent() { return _extent; }
+
+void ComputePart::setGPUShare(float share) { _gpuShare = share; }
+
+int ComputePart::getRows() { return _rows; }
+
+void ComputePart::setAASamples(int aaSamples) { _aaSamples = std::clamp(aaSamples, 1, 100); }
+
+int ComputePart::getAASamples() { return _aaSamples; }
+
+int ComputePart::getMaxDepth() { return _maxDepth; }
+
+bool ComputePart::isBVH() { return _useBVH; }
+
+bool ComputePart::isNEE() { return _useNEE; }
+
+bool ComputePart::isLightBVH() { return _useLightBVH; }
+
+uint32_t ComputePart::getFrameIndex() { return _frameIndex - 1; }
+
+float ComputePart::getTime() { return _time; }
+
+float ComputePart::getScale() { return _scale; }
+
+float ComputePart::getCacheOccupancy() { return _cacheOccupancy; }
+
+float ComputePart::getGuideOccupancy() { return _guideOccupancy; }
+
+void ComputePart::setReSTIR(bool useReSTIR) { _useReSTIR = useReSTIR; }
+
+std::map<std::string, std::tuple<float*, float, float>> ComputePart::getSlidersFloat() { return _slidersFloat; }
+
+UniformCamera ComputePart::getCamera() { return _camera; }
+
 std::vector<std::shared_ptr<Texture>> ComputePart::getResultTextures() { return _resultTextures; }
 
+std::vector<std::shared_ptr<Texture>> ComputePart::getAlbedoTextures() { return _albedoTextures; }
+
+std::vector<std::shared_ptr<Texture>> ComputePart::getNormalDepthTextures() { return _normalDepthTextures; }
+
+std::shared_ptr<UniformBuffer> ComputePart::getUniformBufferSpheres() { return _uniformBufferSpheres; }
+
+std::shared_ptr<UniformBuffer> ComputePart::getUniformBufferHitboxes() { return _uniformBufferHitboxes; }
+
+std::shared_ptr<StorageBuffer> ComputePart::getStorageBufferLights() { return _storageBufferLights; }
+
 std::shared_ptr<Pipeline> ComputePart::getPipeline() { return _pipeline; }
 std::shared_ptr<DescriptorSet> ComputePart::getDescriptorSet() { return _descriptorSet; }
\ No newline at end of file
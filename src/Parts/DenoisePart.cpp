@@ -0,0 +1,158 @@
+#include "DenoisePart.h"
+#include <algorithm>
+
+struct DenoiseParameters {
+  int width;
+  int height;
+  int stepWidth;
+  float sigmaColor;
+  float sigmaNormal;
+  float sigmaDepth;
+  float sigmaAlbedo;
+};
+
+// sources: 0 - input, 1 and 2 - ping-pong textures
+// destinations: 0 and 1 - ping-pong textures, 2 - result
+enum DenoiseTarget { DENOISE_PING = 0, DENOISE_PONG = 1, DENOISE_RESULT = 2 };
+
+DenoisePart::DenoisePart(std::vector<std::shared_ptr<Texture>> inputTextures,
+                         std::vector<std::shared_ptr<Texture>> albedoTextures,
+                         std::vector<std::shared_ptr<Texture>> normalDepthTextures,
+                         std::shared_ptr<Device> device,
+                         std::shared_ptr<Queue> queue,
+                         std::shared_ptr<CommandBuffer> commandBuffer,
+                         std::shared_ptr<CommandPool> commandPool,
+                         std::shared_ptr<Settings> settings) {
+  _device = device;
+  _queue = queue;
+  _commandBuffer = commandBuffer;
+  _commandPool = commandPool;
+  _settings = settings;
+  _inputTextures = inputTextures;
+
+  auto createTexture = [&](VkImageUsageFlags usage) {
+    return std::make_shared<Texture>(settings->getResolution(), VK_FORMAT_R16G16B16A16_SFLOAT, usage, commandPool,
+                                     queue, device);
+  };
+
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    _pingPongTextures.push_back(
+        {createTexture(VK_IMAGE_USAGE_STORAGE_BIT), createTexture(VK_IMAGE_USAGE_STORAGE_BIT)});
+    // read by PostprocessPart, input is copied here if denoiser is disabled
+    _resultTextures.push_back(createTexture(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+  }
+
+  _pairs = {{0, DENOISE_PING},   {0, DENOISE_RESULT}, {1, DENOISE_PONG},
+            {1, DENOISE_RESULT}, {2, DENOISE_PING},   {2, DENOISE_RESULT}};
+  std::vector<std::shared_ptr<Texture>> setInput, setAlbedo, setNormalDepth, setOutput;
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    for (auto [source, destination] : _pairs) {
+      setInput.push_back(source == 0 ? inputTextures[i] : _pingPongTextures[i][source - 1]);
+      setOutput.push_back(destination == DENOISE_RESULT ? _resultTextures[i] : _pingPongTextures[i][destination]);
+      setAlbedo.push_back(albedoTextures[i]);
+      setNormalDepth.push_back(normalDepthTextures[i]);
+    }
+  }
+
+  _descriptorSetLayout = std::make_shared<DescriptorSetLayout>(device);
+  _descriptorSetLayout->createDenoise();
+  _descriptorPool = std::make_shared<DescriptorPool>(100, device);
+  _descriptorSet = std::make_shared<DescriptorSet>(setInput.size(), _descriptorSetLayout, _descriptorPool, device);
+  _descriptorSet->createDenoise(setInput, setAlbedo, setNormalDepth, setOutput);
+
+  _shader = std::make_shared<Shader>(device);
+  _shader->add("../shaders/denoise.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _pipeline = std::make_shared<Pipeline>(_shader, _descriptorSetLayout, device);
+  VkPushConstantRange pushConstant{};
+  pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstant.offset = 0;
+  pushConstant.size = sizeof(DenoiseParameters);
+  _pipeline->createCompute(nullptr, {pushConstant});
+
+  // begin and end timestamps for every frame in flight
+  _queryPool = std::make_shared<QueryPool>(2 * settings->getMaxFramesInFlight(), device);
+
+  _checkboxes["denoise"] = &_enabled;
+  _sliders["denoise_iterations"] = {&_iterations, 1, 8};
+  _slidersFloat["sigma_color"] = {&_sigmaColor, 0.01f, 4.f};
+  _slidersFloat["sigma_normal"] = {&_sigmaNormal, 1.f, 128.f};
+  _slidersFloat["sigma_depth"] = {&_sigmaDepth, 0.001f, 1.f};
+  _slidersFloat["sigma_albedo"] = {&_sigmaAlbedo, 0.01f, 1.f};
+}
+
+int DenoisePart::_getSetIndex(int currentFrame, int source, int destination) {
+  auto pair = std::find(_pairs.begin(), _pairs.end(), std::tuple{source, destination});
+  return currentFrame * _pairs.size() + std::distance(_pairs.begin(), pair);
+}
+
+void DenoisePart::draw(int currentFrame, std::tuple<int, int> extent) {
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  if (auto times = _queryPool->getFrameTimes(currentFrame, 2)) _time = times.value()[0];
+  _queryPool->resetFrame(commandBuffer, currentFrame, 2);
+
+  // ray tracer writes color and guide buffers
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0,
+                       nullptr, 0, nullptr);
+  // bottom of pipe timestamp is written when all previous work is finished, so ray tracing isn't included
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * currentFrame);
+
+  if (_enabled == false) {
+    VkImageCopy region{};
+    region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    auto [width, height] = extent;
+    region.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    vkCmdCopyImage(commandBuffer, _inputTextures[currentFrame]->getImageView()->getImage()->getImage(),
+                   VK_IMAGE_LAYOUT_GENERAL, _resultTextures[currentFrame]->getImageView()->getImage()->getImage(),
+                   VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  } else {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipeline());
+    auto [width, height] = extent;
+    int source = 0;
+    for (int i = 0; i < _iterations; i++) {
+      int destination = (i == _iterations - 1) ? DENOISE_RESULT : i % 2;
+      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipelineLayout(), 0, 1,
+                              &_descriptorSet->getDescriptorSets()[_getSetIndex(currentFrame, source, destination)],
+                              0, 0);
+      DenoiseParameters parameters{};
+      parameters.width = width;
+      parameters.height = height;
+      parameters.stepWidth = 1 << i;
+      // noise is reduced after every iteration, so color difference becomes more reliable edge indicator
+      parameters.sigmaColor = _sigmaColor / (1 << i);
+      parameters.sigmaNormal = _sigmaNormal;
+      parameters.sigmaDepth = _sigmaDepth;
+      parameters.sigmaAlbedo = _sigmaAlbedo;
+      vkCmdPushConstants(commandBuffer, _pipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                         sizeof(DenoiseParameters), &parameters);
+      vkCmdDispatch(commandBuffer, (width + 15) / 16, (height + 15) / 16, 1);
+
+      if (i < _iterations - 1) {
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+      }
+      source = destination + 1;
+    }
+  }
+
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * currentFrame + 1);
+}
+
+float DenoisePart::getTime() { return _time; }
+
+std::map<std::string, bool*> DenoisePart::getCheckboxes() { return _checkboxes; }
+
+std::map<std::string, std::tuple<int*, int, int>> DenoisePart::getSliders() { return _sliders; }
+
+std::map<std::string, std::tuple<float*, float, float>> DenoisePart::getSlidersFloat() { return _slidersFloat; }
+
+std::vector<std::shared_ptr<Texture>> DenoisePart::getResultTextures() { return _resultTextures; }
@@ -0,0 +1,152 @@
+#include "HybridPart.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+
+HybridPart::HybridPart(std::shared_ptr<Scene> scene,
+                       std::shared_ptr<Device> device,
+                       std::shared_ptr<CommandBuffer> commandBuffer,
+                       std::shared_ptr<Settings> settings) {
+  _device = device;
+  _commandBuffer = commandBuffer;
+  _settings = settings;
+  // one hardware thread is left for recording and submitting frames
+  _scheduler = std::make_shared<TileScheduler>(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+  _pathTracer = std::make_shared<PathTracer>(scene, _scheduler, settings->getResolution());
+
+  auto [width, height] = settings->getResolution();
+  // result and normal-depth are half floats, albedo is unorm, normal-depth offset can be rounded up by 4 bytes
+  VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * (8 + 4 + 8) + 4;
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    auto buffer = std::make_shared<Buffer>(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                           device);
+    buffer->map();
+    _stagingBuffers.push_back(buffer);
+    _gpuRows.push_back(0);
+  }
+
+  _checkboxes["hybrid"] = &_enabled;
+}
+
+std::tuple<VkDeviceSize, VkDeviceSize> HybridPart::_getOffsets(VkDeviceSize pixels) {
+  VkDeviceSize albedo = pixels * 8;
+  // 8 bytes texels of R16G16B16A16 follow 4 bytes ones, so the end of albedo is aligned to 4 only
+  VkDeviceSize normalDepth = (albedo + pixels * 4 + 7) & ~static_cast<VkDeviceSize>(7);
+  return {albedo, normalDepth};
+}
+
+void HybridPart::_updateShare(int currentFrame, float gpuTime) {
+  int gpuRows = _gpuRows[currentFrame];
+  if (gpuTime <= 0.f || _cpuTime <= 0.f || gpuRows == 0 || _cpuRows == 0) return;
+  // rows per millisecond of both sides, the share which makes them finish together is proportional to them
+  float gpuSpeed = gpuRows / gpuTime;
+  float cpuSpeed = _cpuRows / _cpuTime;
+  float desired = gpuSpeed / (gpuSpeed + cpuSpeed);
+  // move only part of the way, measurement is from one frame and noisy
+  _gpuShare = std::clamp(_gpuShare + (desired - _gpuShare) * 0.25f, 0.f, 1.f);
+}
+
+void HybridPart::_trace(int currentFrame,
+                        UniformCamera camera,
+                        std::tuple<int, int> extent,
+                        uint32_t frameIndex,
+                        int rows) {
+  auto [width, height] = extent;
+  int fullWidth = std::get<0>(_settings->getResolution());
+  _pathTracer->render(camera, extent, frameIndex, rows);
+
+  // CPU rows are the top ones of the images, rows are packed tightly one after another
+  int cpuRows = height - rows;
+  auto [albedoOffset, normalDepthOffset] = _getOffsets(static_cast<VkDeviceSize>(width) * cpuRows);
+  auto memory = static_cast<uint8_t*>(_stagingBuffers[currentFrame]->getMappedMemory());
+  auto result = reinterpret_cast<uint64_t*>(memory);
+  auto albedo = reinterpret_cast<uint32_t*>(memory + albedoOffset);
+  auto normalDepth = reinterpret_cast<uint64_t*>(memory + normalDepthOffset);
+  for (int y = 0; y < cpuRows; y++) {
+    for (int x = 0; x < width; x++) {
+      int source = y * fullWidth + x;
+      int destination = y * width + x;
+      result[destination] = glm::packHalf4x16(_pathTracer->getResult()[source]);
+      albedo[destination] = glm::packUnorm4x8(_pathTracer->getAlbedo()[source]);
+      normalDepth[destination] = glm::packHalf4x16(_pathTracer->getNormalDepth()[source]);
+    }
+  }
+  _cpuRows = cpuRows;
+  _cpuTime = _pathTracer->getTime();
+}
+
+void HybridPart::draw(int currentFrame, std::shared_ptr<ComputePart> computePart) {
+  if (_job.valid()) _job.get();
+  if (_enabled == false) {
+    _gpuShare = 0.5f;
+    _gpuRows[currentFrame] = 0;
+    return;
+  }
+
+  auto [width, height] = computePart->getExtent();
+  int rows = computePart->getRows();
+  _updateShare(currentFrame, computePart->getTime());
+  _gpuRows[currentFrame] = rows;
+  // GPU part covers everything, e.g. the extent is too small to split
+  if (rows >= height) return;
+
+  _pathTracer->setAASamples(computePart->getAASamples());
+  _pathTracer->setMaxDepth(computePart->getMaxDepth());
+  _pathTracer->setBVH(computePart->isBVH());
+  _pathTracer->setNEE(computePart->isNEE());
+  _pathTracer->setLightBVH(computePart->isLightBVH());
+  // fence of this frame slot has been waited, so GPU doesn't read the staging buffer of the slot anymore
+  _job = std::async(std::launch::async, &HybridPart::_trace, this, currentFrame, computePart->getCamera(),
+                    computePart->getExtent(), computePart->getFrameIndex(), rows);
+}
+
+void HybridPart::merge(int currentFrame, std::shared_ptr<ComputePart> computePart) {
+  // nothing is traced on CPU this frame
+  if (_job.valid() == false) return;
+  // GPU runs the submitted dispatch meanwhile, host writes of the staging buffer are made visible by the submit
+  _job.get();
+
+  auto [width, height] = computePart->getExtent();
+  int rows = computePart->getRows();
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  // dispatch writes other rows of the same images
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+
+  auto [albedoOffset, normalDepthOffset] = _getOffsets(static_cast<VkDeviceSize>(width) * (height - rows));
+  std::vector<std::tuple<std::shared_ptr<Texture>, VkDeviceSize>> targets = {
+      {computePart->getResultTextures()[currentFrame], 0},
+      {computePart->getAlbedoTextures()[currentFrame], albedoOffset},
+      {computePart->getNormalDepthTextures()[currentFrame], normalDepthOffset}};
+  for (auto& [texture, offset] : targets) {
+    VkBufferImageCopy region{};
+    region.bufferOffset = offset;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height - rows), 1};
+    vkCmdCopyBufferToImage(commandBuffer, _stagingBuffers[currentFrame]->getData(),
+                           texture->getImageView()->getImage()->getImage(), VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  }
+
+  // the next passes read the whole images
+  memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+float HybridPart::getGPUShare() { return _enabled ? _gpuShare : 1.f; }
+
+std::map<std::string, bool*> HybridPart::getCheckboxes() { return _checkboxes; }
+
+float HybridPart::getCPUTime() { return _cpuTime; }
+
+int HybridPart::getThreads() { return _scheduler->getThreads(); }
+
+HybridPart::~HybridPart() {
+  if (_job.valid()) _job.get();
+}
@@ -0,0 +1,240 @@
+#include "PostprocessPart.h"
+#include <cmath>
+
+// shared by postprocess, histogram and exposure shaders, the latter two declare only prefix
+struct PostprocessParameters {
+  int width;
+  int height;
+  float exposure;
+  int encodeGamma;
+  int autoExposure;
+  float minLogLuminance;
+  float logLuminanceRange;
+  float adaptation;
+  float sharpness;
+  float saturation;
+  float contrast;
+  float temperature;
+  float vignette;
+};
+
+struct PostprocessConstants {
+  int tonemapper;
+  VkBool32 sharpen;
+  VkBool32 colorGrading;
+  VkBool32 grayscale;
+  VkBool32 vignette;
+};
+
+struct Exposure {
+  float exposure;
+  float averageLuminance;
+};
+
+constexpr int histogramBins = 256;
+// begin, after histogram, after exposure, end
+constexpr int timestampsNumber = 4;
+
+PostprocessPart::PostprocessPart(std::vector<std::shared_ptr<Texture>> inputTextures,
+                                 std::shared_ptr<Device> device,
+                                 std::shared_ptr<Queue> queue,
+                                 std::shared_ptr<CommandBuffer> commandBuffer,
+                                 std::shared_ptr<CommandPool> commandPool,
+                                 std::shared_ptr<Settings> settings) {
+  _device = device;
+  _queue = queue;
+  _commandBuffer = commandBuffer;
+  _commandPool = commandPool;
+  _settings = settings;
+
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    // sampled or blitted to swapchain by ScreenPart, values are already in display range
+    _resultTextures.push_back(std::make_shared<Texture>(
+        settings->getResolution(), VK_FORMAT_R16G16B16A16_SFLOAT,
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, commandPool, queue,
+        device));
+  }
+
+  // both stay on GPU, histogram is cleared by exposure pass after reading, zero exposure means not measured yet
+  _storageBufferHistogram = std::make_shared<StorageBuffer>(histogramBins * sizeof(uint32_t), nullptr, commandPool,
+                                                            queue, device);
+  _storageBufferExposure = std::make_shared<StorageBuffer>(sizeof(Exposure), nullptr, commandPool, queue, device);
+
+  _descriptorSetLayout = std::make_shared<DescriptorSetLayout>(device);
+  _descriptorSetLayout->createPostprocess();
+  _descriptorPool = std::make_shared<DescriptorPool>(100, device);
+  _descriptorSet = std::make_shared<DescriptorSet>(settings->getMaxFramesInFlight(), _descriptorSetLayout,
+                                                   _descriptorPool, device);
+  _descriptorSet->createPostprocess(inputTextures, _resultTextures, _storageBufferHistogram, _storageBufferExposure);
+
+  _shader = std::make_shared<Shader>(device);
+  _shader->add("../shaders/postprocess.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _pipeline = std::make_shared<Pipeline>(_shader, _descriptorSetLayout, device);
+
+  VkPushConstantRange pushConstant{};
+  pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstant.offset = 0;
+  pushConstant.size = sizeof(PostprocessParameters);
+  // SPIR-V with subgroup operations declares their capabilities, so pipeline creation fails on devices without them
+  // even if the code isn't reached; such devices get shaders built without it, they use shared memory atomics only
+  auto subgroup = device->getSubgroupProperties();
+  bool useSubgroups = (subgroup.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+                      (subgroup.supportedOperations & VK_SUBGROUP_FEATURE_BALLOT_BIT) &&
+                      (subgroup.supportedOperations & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+  std::string suffix = useSubgroups ? "" : "_nosubgroups";
+  _histogramShader = std::make_shared<Shader>(device);
+  _histogramShader->add("../shaders/histogram" + suffix + ".spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _histogramPipeline = std::make_shared<Pipeline>(_histogramShader, _descriptorSetLayout, device);
+  _histogramPipeline->createCompute(nullptr, {pushConstant});
+  _exposureShader = std::make_shared<Shader>(device);
+  _exposureShader->add("../shaders/exposure" + suffix + ".spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _exposurePipeline = std::make_shared<Pipeline>(_exposureShader, _descriptorSetLayout, device);
+  _exposurePipeline->createCompute(nullptr, {pushConstant});
+  _lastTime = std::chrono::steady_clock::now();
+
+  _queryPool = std::make_shared<QueryPool>(timestampsNumber * settings->getMaxFramesInFlight(), device);
+  _times = {{"histogram", 0.f}, {"exposure", 0.f}, {"effects", 0.f}};
+
+  _slidersFloat["exposure"] = {&_exposure, -8.f, 8.f};
+  _sliders["tonemapper"] = {&_tonemapper, 0, 2};
+  _checkboxes["auto_exposure"] = &_autoExposure;
+  _slidersFloat["min_log_luminance"] = {&_minLogLuminance, -16.f, 0.f};
+  _slidersFloat["log_luminance_range"] = {&_logLuminanceRange, 1.f, 32.f};
+  _slidersFloat["adaptation_speed"] = {&_adaptationSpeed, 0.1f, 10.f};
+  _checkboxes["sharpen"] = &_sharpen;
+  _slidersFloat["sharpness"] = {&_sharpness, 0.f, 2.f};
+  _checkboxes["color_grading"] = &_colorGrading;
+  _slidersFloat["saturation"] = {&_saturation, 0.f, 2.f};
+  _slidersFloat["contrast"] = {&_contrast, 0.5f, 2.f};
+  _slidersFloat["temperature"] = {&_temperature, -1.f, 1.f};
+  _checkboxes["grayscale"] = &_grayscale;
+  _checkboxes["vignette"] = &_vignette;
+  _slidersFloat["vignette_strength"] = {&_vignetteStrength, 0.f, 1.f};
+  // compile default variant upfront
+  _selectVariant();
+}
+
+void PostprocessPart::_selectVariant(bool async) {
+  PostprocessConstants constants{};
+  constants.tonemapper = _tonemapper;
+  constants.sharpen = _sharpen;
+  constants.colorGrading = _colorGrading;
+  constants.grayscale = _grayscale;
+  constants.vignette = _vignette;
+
+  std::array<VkSpecializationMapEntry, 5> entries{};
+  entries[0] = {0, offsetof(PostprocessConstants, tonemapper), sizeof(int)};
+  entries[1] = {1, offsetof(PostprocessConstants, sharpen), sizeof(VkBool32)};
+  entries[2] = {2, offsetof(PostprocessConstants, colorGrading), sizeof(VkBool32)};
+  entries[3] = {3, offsetof(PostprocessConstants, grayscale), sizeof(VkBool32)};
+  entries[4] = {4, offsetof(PostprocessConstants, vignette), sizeof(VkBool32)};
+
+  VkSpecializationInfo specializationInfo{};
+  specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+  specializationInfo.pMapEntries = entries.data();
+  specializationInfo.dataSize = sizeof(constants);
+  specializationInfo.pData = &constants;
+  // every combination of effects is compiled only once, switching back and forth is just a lookup
+  VkPushConstantRange pushConstant{};
+  pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstant.offset = 0;
+  pushConstant.size = sizeof(PostprocessParameters);
+  if (async)
+    _pipeline->selectCompute(&specializationInfo, {pushConstant});
+  else
+    _pipeline->createCompute(&specializationInfo, {pushConstant});
+}
+
+void PostprocessPart::draw(int currentFrame, std::tuple<int, int> extent) {
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  int firstQuery = timestampsNumber * currentFrame;
+  if (auto times = _queryPool->getFrameTimes(currentFrame, timestampsNumber)) {
+    _times["histogram"] = times.value()[0];
+    _times["exposure"] = times.value()[1];
+    _times["effects"] = times.value()[2];
+  }
+  _queryPool->resetFrame(commandBuffer, currentFrame, timestampsNumber);
+
+  // denoiser output is written either by compute shader or by copy if denoiser is disabled,
+  // previous use of the result by fragment shader of this frame slot is finished by fence;
+  // histogram pass writes bins and result the previous passes wrote, so write after write needs the barrier too
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(), firstQuery);
+
+  auto now = std::chrono::steady_clock::now();
+  float deltaTime = std::chrono::duration<float>(now - _lastTime).count();
+  _lastTime = now;
+  auto [width, height] = extent;
+  PostprocessParameters parameters{};
+  parameters.width = width;
+  parameters.height = height;
+  parameters.exposure = std::exp2(_exposure);
+  parameters.encodeGamma = _encodeGamma;
+  parameters.autoExposure = _autoExposure;
+  parameters.minLogLuminance = _minLogLuminance;
+  parameters.logLuminanceRange = _logLuminanceRange;
+  // frame rate independent exponential adaptation
+  parameters.adaptation = 1.f - std::exp(-deltaTime * _adaptationSpeed);
+  parameters.sharpness = _sharpness;
+  parameters.saturation = _saturation;
+  parameters.contrast = _contrast;
+  parameters.temperature = _temperature;
+  parameters.vignette = _vignetteStrength;
+
+  // reductions over the whole image can't be fused with per pixel effects, exposure is needed before them
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  if (_autoExposure) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _histogramPipeline->getPipeline());
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _histogramPipeline->getPipelineLayout(), 0,
+                            1, &_descriptorSet->getDescriptorSets()[currentFrame], 0, 0);
+    vkCmdPushConstants(commandBuffer, _histogramPipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(PostprocessParameters), &parameters);
+    vkCmdDispatch(commandBuffer, (width + 15) / 16, (height + 15) / 16, 1);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  }
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      firstQuery + 1);
+
+  if (_autoExposure) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _exposurePipeline->getPipeline());
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _exposurePipeline->getPipelineLayout(), 0,
+                            1, &_descriptorSet->getDescriptorSets()[currentFrame], 0, 0);
+    vkCmdPushConstants(commandBuffer, _exposurePipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(PostprocessParameters), &parameters);
+    vkCmdDispatch(commandBuffer, 1, 1, 1);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  }
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      firstQuery + 2);
+
+  _selectVariant(true);
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipeline());
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipelineLayout(), 0, 1,
+                          &_descriptorSet->getDescriptorSets()[currentFrame], 0, 0);
+  vkCmdPushConstants(commandBuffer, _pipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(PostprocessParameters), &parameters);
+  vkCmdDispatch(commandBuffer, (width + 15) / 16, (height + 15) / 16, 1);
+
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      firstQuery + 3);
+}
+
+void PostprocessPart::setEncodeGamma(bool encodeGamma) { _encodeGamma = encodeGamma; }
+
+std::map<std::string, float> PostprocessPart::getTimes() { return _times; }
+
+std::map<std::string, bool*> PostprocessPart::getCheckboxes() { return _checkboxes; }
+
+std::map<std::string, std::tuple<int*, int, int>> PostprocessPart::getSliders() { return _sliders; }
+
+std::map<std::string, std::tuple<float*, float, float>> PostprocessPart::getSlidersFloat() { return _slidersFloat; }
+
+std::vector<std::shared_ptr<Texture>> PostprocessPart::getResultTextures() { return _resultTextures; }
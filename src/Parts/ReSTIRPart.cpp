@@ -0,0 +1,197 @@
+#include "ReSTIRPart.h"
+
+struct UniformReSTIR {
+  UniformCamera current;
+  UniformCamera previous;
+  glm::ivec2 extent;
+  glm::ivec2 previousExtent;
+  int candidates;
+  int spatialSamples;
+  float spatialRadius;
+  int maxHistory;
+  float depthThreshold;
+  float normalThreshold;
+  int reset;
+  uint32_t frame;
+};
+
+// matches std430 layout of Reservoir in restir.comp
+struct Reservoir {
+  alignas(16) glm::vec3 position;
+  int light;
+  float weightSum;
+  float M;
+  float W;
+};
+
+struct ReSTIRStatistics {
+  uint32_t shadedPixels;
+  uint32_t visibleSamples;
+  uint32_t candidatesSum;
+};
+
+ReSTIRPart::ReSTIRPart(std::shared_ptr<ComputePart> computePart,
+                       std::shared_ptr<Device> device,
+                       std::shared_ptr<Queue> queue,
+                       std::shared_ptr<CommandBuffer> commandBuffer,
+                       std::shared_ptr<CommandPool> commandPool,
+                       std::shared_ptr<Settings> settings) {
+  _device = device;
+  _queue = queue;
+  _commandBuffer = commandBuffer;
+  _commandPool = commandPool;
+  _settings = settings;
+  _previousExtent = settings->getResolution();
+
+  auto [width, height] = settings->getResolution();
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    _initialReservoirs.push_back(
+        std::make_shared<StorageBuffer>(width * height * sizeof(Reservoir), nullptr, commandPool, queue, device));
+    _finalReservoirs.push_back(
+        std::make_shared<StorageBuffer>(width * height * sizeof(Reservoir), nullptr, commandPool, queue, device));
+    auto statistics = std::make_shared<Buffer>(
+        sizeof(ReSTIRStatistics), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, device);
+    statistics->map();
+    memset(statistics->getMappedMemory(), 0, sizeof(ReSTIRStatistics));
+    _statistics.push_back(statistics);
+  }
+
+  // history of the frame is result of the previous frame, frames in flight are used in order
+  auto normalDepth = computePart->getNormalDepthTextures();
+  std::vector<std::shared_ptr<Texture>> historyNormalDepth;
+  std::vector<std::shared_ptr<StorageBuffer>> historyReservoirs;
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    int previous = (i + settings->getMaxFramesInFlight() - 1) % settings->getMaxFramesInFlight();
+    historyNormalDepth.push_back(normalDepth[previous]);
+    historyReservoirs.push_back(_finalReservoirs[previous]);
+  }
+
+  _uniformBuffer = std::make_shared<UniformBuffer>(settings->getMaxFramesInFlight(), sizeof(UniformReSTIR),
+                                                   commandPool, queue, device);
+  _descriptorSetLayout = std::make_shared<DescriptorSetLayout>(device);
+  _descriptorSetLayout->createReSTIR();
+  _descriptorPool = std::make_shared<DescriptorPool>(100, device);
+  _descriptorSet = std::make_shared<DescriptorSet>(settings->getMaxFramesInFlight(), _descriptorSetLayout,
+                                                   _descriptorPool, device);
+  _descriptorSet->createReSTIR(_uniformBuffer, computePart->getUniformBufferSpheres(),
+                               computePart->getUniformBufferHitboxes(), computePart->getStorageBufferLights(),
+                               computePart->getAlbedoTextures(), normalDepth, historyNormalDepth,
+                               computePart->getResultTextures(), _initialReservoirs, _finalReservoirs,
+                               historyReservoirs, _statistics);
+
+  _shader = std::make_shared<Shader>(device);
+  _shader->add("../shaders/restir.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _pipeline = std::make_shared<Pipeline>(_shader, _descriptorSetLayout, device);
+  // index of the pass
+  VkPushConstantRange pushConstant{};
+  pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstant.offset = 0;
+  pushConstant.size = sizeof(int);
+  _pipeline->createCompute(nullptr, {pushConstant});
+
+  // begin and end timestamps for every frame in flight
+  _queryPool = std::make_shared<QueryPool>(2 * settings->getMaxFramesInFlight(), device);
+
+  _checkboxes["restir"] = &_enabled;
+  _sliders["restir_candidates"] = {&_initialCandidates, 1, 32};
+  _sliders["restir_spatial_samples"] = {&_spatialSamples, 0, 8};
+  _sliders["restir_max_history"] = {&_maxHistory, 0, 50};
+  _slidersFloat["restir_spatial_radius"] = {&_spatialRadius, 1.f, 64.f};
+  _slidersFloat["restir_depth_threshold"] = {&_depthThreshold, 0.001f, 0.5f};
+  _slidersFloat["restir_normal_threshold"] = {&_normalThreshold, 0.f, 1.f};
+}
+
+void ReSTIRPart::draw(int currentFrame, UniformCamera camera, std::tuple<int, int> extent) {
+  // history becomes stale while disabled
+  if (_enabled == false) {
+    _reset = true;
+    return;
+  }
+
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  // counters are written in the same frames as timestamps
+  if (auto times = _queryPool->getFrameTimes(currentFrame, 2)) {
+    _time = times.value()[0];
+    auto statistics = static_cast<ReSTIRStatistics*>(_statistics[currentFrame]->getMappedMemory());
+    if (statistics->shadedPixels > 0) {
+      _candidates = static_cast<float>(statistics->candidatesSum) / statistics->shadedPixels;
+      _visible = static_cast<float>(statistics->visibleSamples) / statistics->shadedPixels;
+    }
+  }
+  _queryPool->resetFrame(commandBuffer, currentFrame, 2);
+  vkCmdFillBuffer(commandBuffer, _statistics[currentFrame]->getData(), 0, VK_WHOLE_SIZE, 0);
+
+  UniformReSTIR ubo{};
+  ubo.current = camera;
+  ubo.previous = _previousCamera;
+  ubo.extent = glm::ivec2(std::get<0>(extent), std::get<1>(extent));
+  ubo.previousExtent = glm::ivec2(std::get<0>(_previousExtent), std::get<1>(_previousExtent));
+  ubo.candidates = _initialCandidates;
+  ubo.spatialSamples = _spatialSamples;
+  ubo.spatialRadius = _spatialRadius;
+  ubo.maxHistory = _maxHistory;
+  ubo.depthThreshold = _depthThreshold;
+  ubo.normalThreshold = _normalThreshold;
+  // history is undefined until the first frame is resampled
+  ubo.reset = _reset;
+  ubo.frame = _frame++;
+  void* data;
+  vkMapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory(), 0, sizeof(ubo), 0,
+              &data);
+  memcpy(data, &ubo, sizeof(ubo));
+  vkUnmapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory());
+  _previousCamera = camera;
+  _previousExtent = extent;
+  _reset = false;
+
+  // ray tracer writes color and guide buffers, previous frame writes history reservoirs, counters are cleared
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  // bottom of pipe timestamp is written when all previous work is finished, so ray tracing isn't included
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * currentFrame);
+
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipeline());
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipelineLayout(), 0, 1,
+                          &_descriptorSet->getDescriptorSets()[currentFrame], 0, 0);
+  auto [width, height] = extent;
+  // pass 0: initial candidates and temporal reuse, pass 1: spatial reuse and shading
+  for (int pass = 0; pass < 2; pass++) {
+    vkCmdPushConstants(commandBuffer, _pipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int),
+                       &pass);
+    vkCmdDispatch(commandBuffer, (width + 15) / 16, (height + 15) / 16, 1);
+    // spatial reuse reads reservoirs of neighbors
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    if (pass == 0)
+      vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  }
+
+  // counters are read on host after the fence of this frame slot
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * currentFrame + 1);
+}
+
+bool ReSTIRPart::isEnabled() { return _enabled; }
+
+float ReSTIRPart::getTime() { return _time; }
+
+float ReSTIRPart::getCandidates() { return _candidates; }
+
+float ReSTIRPart::getVisible() { return _visible; }
+
+std::map<std::string, bool*> ReSTIRPart::getCheckboxes() { return _checkboxes; }
+
+std::map<std::string, std::tuple<int*, int, int>> ReSTIRPart::getSliders() { return _sliders; }
+
+std::map<std::string, std::tuple<float*, float, float>> ReSTIRPart::getSlidersFloat() { return _slidersFloat; }
@@ -11,6 +11,8 @@ ScreenPart::ScreenPart(std::vector<std::shared_ptr<Texture>> resultTexture,
   _swapchain = std::make_shared<Swapchain>(window, surface, device);
   _renderPass = std::make_shared<RenderPass>(_swapchain->getImageFormat(), device);
   _renderPass->initialize();
+  _renderPassOverlay = std::make_shared<RenderPass>(_swapchain->getImageFormat(), device);
+  _renderPassOverlay->initializeOverlay();
 
   _frameBuffer = std::make_shared<Framebuffer>(settings->getResolution(), _swapchain->getImageViews(),
                                                _swapchain->getDepthImageView(), _renderPass, device);
@@ -20,13 +22,81 @@ ScreenPart::ScreenPart(std::vector<std::shared_ptr<Texture>> resultTexture,
   shaderGray->add("../shaders/final_fragment.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
   _spriteManager = std::make_shared<SpriteManager>(shaderGray, commandPool, commandBuffer, queue, _renderPass, device,
                                                    settings);
+  // same sprites with edge-aware upscale filter
+  auto shaderUpscale = std::make_shared<Shader>(device);
+  shaderUpscale->add("../shaders/final_vertex.spv", VK_SHADER_STAGE_VERTEX_BIT);
+  shaderUpscale->add("../shaders/upscale_fragment.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+  _spriteManagerUpscale = std::make_shared<SpriteManager>(shaderUpscale, commandPool, commandBuffer, queue,
+                                                          _renderPass, device, settings);
   for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
     _sprites.push_back(_spriteManager->createSprite(resultTexture[i]));
+    _spritesUpscale.push_back(_spriteManagerUpscale->createSprite(resultTexture[i]));
   }
+  _device = device;
+  _commandBuffer = commandBuffer;
+  _resultTextures = resultTexture;
+  _settings = settings;
+  setExtent(settings->getResolution());
+
+  _checkboxes["edge_aware_upscale"] = &_edgeAware;
+  // blit needs transfer usage of swapchain images and blit support of both formats
+  auto sourceFormat = resultTexture[0]->getImageView()->getImage()->getFormat();
+  auto sourceFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  if ((_swapchain->getImageUsage() & VK_IMAGE_USAGE_TRANSFER_DST_BIT) &&
+      device->isFormatFeatureSupported(sourceFormat, VK_IMAGE_TILING_OPTIMAL, sourceFeatures) &&
+      device->isFormatFeatureSupported(_swapchain->getImageFormat(), VK_IMAGE_TILING_OPTIMAL,
+                                       VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+    _checkboxes["direct_present"] = &_directPresent;
+  }
+}
+
+void ScreenPart::blit(int currentFrame, int imageIndex, std::tuple<int, int> extent) {
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  auto swapchainImage = _swapchain->getImageViews()[imageIndex]->getImage()->getImage();
+  // previous content of swapchain image is overwritten completely
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = swapchainImage;
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                       nullptr, 0, nullptr, 1, &barrier);
+
+  // stretch rendered part of the result to the whole screen, blit converts to swapchain format (and sRGB)
+  auto swapchainExtent = _swapchain->getSwapchainExtent();
+  VkImageBlit region{};
+  region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.srcOffsets[1] = {std::get<0>(extent), std::get<1>(extent), 1};
+  region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.dstOffsets[1] = {static_cast<int32_t>(swapchainExtent.width), static_cast<int32_t>(swapchainExtent.height),
+                          1};
+  vkCmdBlitImage(commandBuffer, _resultTextures[currentFrame]->getImageView()->getImage()->getImage(),
+                 VK_IMAGE_LAYOUT_GENERAL, swapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region,
+                 VK_FILTER_LINEAR);
 }
 
-std::shared_ptr<RenderPass> ScreenPart::getRenderPass() { return _renderPass; }
+bool ScreenPart::isDirectPresent() { return _directPresent; }
+
+void ScreenPart::setExtent(std::tuple<int, int> extent) {
+  auto [width, height] = _settings->getResolution();
+  // model matrix of sprite scales texture coordinates to the rendered part of the texture
+  glm::mat4 model = glm::scale(glm::mat4(1.f), glm::vec3(static_cast<float>(std::get<0>(extent)) / width,
+                                                        static_cast<float>(std::get<1>(extent)) / height, 1.f));
+  for (auto sprite : _sprites) sprite->setModel(model);
+  for (auto sprite : _spritesUpscale) sprite->setModel(model);
+}
+
+std::map<std::string, bool*> ScreenPart::getCheckboxes() { return _checkboxes; }
+
+std::shared_ptr<RenderPass> ScreenPart::getRenderPass() { return _directPresent ? _renderPassOverlay : _renderPass; }
 std::shared_ptr<Framebuffer> ScreenPart::getFramebuffer() { return _frameBuffer; }
-std::vector<std::shared_ptr<Sprite>> ScreenPart::getSprites() { return _sprites; }
-std::shared_ptr<SpriteManager> ScreenPart::getSpriteManager() { return _spriteManager; }
+std::vector<std::shared_ptr<Sprite>> ScreenPart::getSprites() { return _edgeAware ? _spritesUpscale : _sprites; }
+std::shared_ptr<SpriteManager> ScreenPart::getSpriteManager() {
+  return _edgeAware ? _spriteManagerUpscale : _spriteManager;
+}
 std::shared_ptr<Swapchain> ScreenPart::getSwapchain() { return _swapchain; }
\ No newline at end of file
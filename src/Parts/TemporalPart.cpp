@@ -0,0 +1,106 @@
+#include "TemporalPart.h"
+
+struct UniformTemporal {
+  UniformCamera current;
+  UniformCamera previous;
+  int maxHistory;
+  float depthThreshold;
+  float normalThreshold;
+  int reset;
+  glm::ivec2 extent;
+  glm::ivec2 previousExtent;
+};
+
+TemporalPart::TemporalPart(std::vector<std::shared_ptr<Texture>> inputTextures,
+                           std::vector<std::shared_ptr<Texture>> normalDepthTextures,
+                           std::shared_ptr<Device> device,
+                           std::shared_ptr<Queue> queue,
+                           std::shared_ptr<CommandBuffer> commandBuffer,
+                           std::shared_ptr<CommandPool> commandPool,
+                           std::shared_ptr<Settings> settings) {
+  _device = device;
+  _queue = queue;
+  _commandBuffer = commandBuffer;
+  _commandPool = commandPool;
+  _settings = settings;
+  _previousExtent = settings->getResolution();
+
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    // read by denoiser and copied to its output if denoiser is disabled
+    _resultTextures.push_back(std::make_shared<Texture>(settings->getResolution(), VK_FORMAT_R16G16B16A16_SFLOAT,
+                                                        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                                                        commandPool, queue, device));
+  }
+
+  // history of the frame is result of the previous frame, frames in flight are used in order
+  std::vector<std::shared_ptr<Texture>> history, historyNormalDepth;
+  for (int i = 0; i < settings->getMaxFramesInFlight(); i++) {
+    int previous = (i + settings->getMaxFramesInFlight() - 1) % settings->getMaxFramesInFlight();
+    history.push_back(_resultTextures[previous]);
+    historyNormalDepth.push_back(normalDepthTextures[previous]);
+  }
+
+  _uniformBuffer = std::make_shared<UniformBuffer>(settings->getMaxFramesInFlight(), sizeof(UniformTemporal),
+                                                   commandPool, queue, device);
+  _descriptorSetLayout = std::make_shared<DescriptorSetLayout>(device);
+  _descriptorSetLayout->createTemporal();
+  _descriptorPool = std::make_shared<DescriptorPool>(100, device);
+  _descriptorSet = std::make_shared<DescriptorSet>(settings->getMaxFramesInFlight(), _descriptorSetLayout,
+                                                   _descriptorPool, device);
+  _descriptorSet->createTemporal(_uniformBuffer, inputTextures, normalDepthTextures, history, historyNormalDepth,
+                                 _resultTextures);
+
+  _shader = std::make_shared<Shader>(device);
+  _shader->add("../shaders/temporal.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+  _pipeline = std::make_shared<Pipeline>(_shader, _descriptorSetLayout, device);
+  _pipeline->createCompute();
+
+  _checkboxes["temporal"] = &_enabled;
+  _sliders["max_history"] = {&_maxHistory, 1, 64};
+  _slidersFloat["depth_threshold"] = {&_depthThreshold, 0.001f, 0.5f};
+  _slidersFloat["normal_threshold"] = {&_normalThreshold, 0.f, 1.f};
+}
+
+void TemporalPart::draw(int currentFrame, UniformCamera camera, std::tuple<int, int> extent) {
+  UniformTemporal ubo{};
+  ubo.current = camera;
+  ubo.previous = _previousCamera;
+  ubo.maxHistory = _enabled ? _maxHistory : 1;
+  ubo.depthThreshold = _depthThreshold;
+  ubo.normalThreshold = _normalThreshold;
+  // history is undefined until the first frame is accumulated
+  ubo.reset = _reset;
+  ubo.extent = glm::ivec2(std::get<0>(extent), std::get<1>(extent));
+  ubo.previousExtent = glm::ivec2(std::get<0>(_previousExtent), std::get<1>(_previousExtent));
+  void* data;
+  vkMapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory(), 0, sizeof(ubo), 0,
+              &data);
+  memcpy(data, &ubo, sizeof(ubo));
+  vkUnmapMemory(_device->getLogicalDevice(), _uniformBuffer->getBuffer()[currentFrame]->getMemory());
+  _previousCamera = camera;
+  _previousExtent = extent;
+  _reset = false;
+
+  auto commandBuffer = _commandBuffer->getCommandBuffer()[currentFrame];
+  // ray tracer writes color and guide buffers, previous frame writes history
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipeline());
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->getPipelineLayout(), 0, 1,
+                          &_descriptorSet->getDescriptorSets()[currentFrame], 0, 0);
+  auto [width, height] = extent;
+  vkCmdDispatch(commandBuffer, (width + 15) / 16, (height + 15) / 16, 1);
+}
+
+std::map<std::string, bool*> TemporalPart::getCheckboxes() { return _checkboxes; }
+
+std::map<std::string, std::tuple<int*, int, int>> TemporalPart::getSliders() { return _sliders; }
+
+std::map<std::string, std::tuple<float*, float, float>> TemporalPart::getSlidersFloat() { return _slidersFloat; }
+
+std::vector<std::shared_ptr<Texture>> TemporalPart::getResultTextures() { return _resultTextures; }
@@ -0,0 +1,360 @@
+#include "Scene.h"
+#include <algorithm>
+
+UniformCamera createCamera(glm::vec3 origin, glm::vec3 direction, glm::vec3 up, float fov) {
+  UniformCamera camera{};
+  camera.fov = glm::tan(glm::radians(fov) / 2.f);
+  camera.camera = glm::transpose(glm::lookAt(origin, origin + direction, up));
+  camera.origin = origin;
+  return camera;
+}
+
+HitBoxTemp mergeHitBoxes(std::vector<HitBoxTemp>& hitBox, int left, int right) {
+  auto leftHitBox = hitBox[left];
+  auto rightHitBox = hitBox[right];
+  HitBoxTemp result;
+  glm::vec3 minLeft = leftHitBox.center - leftHitBox.bias;
+  glm::vec3 maxLeft = leftHitBox.center + leftHitBox.bias;
+  glm::vec3 minRight = rightHitBox.center - rightHitBox.bias;
+  glm::vec3 maxRight = rightHitBox.center + rightHitBox.bias;
+
+  glm::vec3 minBoth = glm::vec3(std::min(minLeft.x, minRight.x), std::min(minLeft.y, minRight.y),
+                                std::min(minLeft.z, minRight.z));
+  glm::vec3 maxBoth = glm::vec3(std::max(maxLeft.x, maxRight.x), std::max(maxLeft.y, maxRight.y),
+                                std::max(maxLeft.z, maxRight.z));
+
+  result.center = (minBoth + maxBoth) / 2.f;
+  result.bias = result.center - minBoth;
+  return result;
+}
+
+void calculateThreadedBVH(std::vector<HitBoxTemp> hitBox, UniformHitBox& hitBoxResult) {
+  hitBoxResult.hitbox[0].next = hitBox[1].index;
+  hitBoxResult.hitbox[0].exit = -1;
+  hitBoxResult.hitbox[0].min = hitBox[0].center - hitBox[0].bias;
+  hitBoxResult.hitbox[0].max = hitBox[0].center + hitBox[0].bias;
+  hitBoxResult.hitbox[0].sphere = hitBox[0].sphere;
+
+  for (int i = 1; i < hitBox.size() - 1; i++) {
+    hitBoxResult.hitbox[i].next = hitBox[i + 1].index;
+    hitBoxResult.hitbox[i].exit = -1;
+    hitBoxResult.hitbox[i].min = hitBox[i].center - hitBox[i].bias;
+    hitBoxResult.hitbox[i].max = hitBox[i].center + hitBox[i].bias;
+    hitBoxResult.hitbox[i].sphere = hitBox[i].sphere;
+
+    if (hitBox[i].left == -1 && hitBox[i].right == -1) {
+      hitBoxResult.hitbox[i].exit = hitBoxResult.hitbox[i].next;
+    } else {
+      auto parentNode = hitBox[hitBox[i].parent];
+      if (parentNode.left == hitBox[i].index) {
+        // left
+        // internal
+        hitBoxResult.hitbox[i].exit = parentNode.right;
+      } else {
+        // right
+        // internal
+
+        // check if parent exist and it's not right child
+        while (parentNode.parent != -1) {
+          auto grandparentNode = hitBox[parentNode.parent];
+          if (grandparentNode.right != parentNode.index) {
+            hitBoxResult.hitbox[i].exit = grandparentNode.right;
+            break;
+          }
+          parentNode = grandparentNode;
+        }
+      }
+    }
+  }
+
+  hitBoxResult.hitbox[hitBox.size() - 1].next = -1;
+  hitBoxResult.hitbox[hitBox.size() - 1].exit = -1;
+  hitBoxResult.hitbox[hitBox.size() - 1].min = hitBox[hitBox.size() - 1].center - hitBox[hitBox.size() - 1].bias;
+  hitBoxResult.hitbox[hitBox.size() - 1].max = hitBox[hitBox.size() - 1].center + hitBox[hitBox.size() - 1].bias;
+  hitBoxResult.hitbox[hitBox.size() - 1].sphere = hitBox[hitBox.size() - 1].sphere;
+}
+
+int Scene::_calculateHitbox(std::vector<UniformSphere> spheres, std::vector<HitBoxTemp>& hitBox, int parent) {
+  HitBoxTemp current;
+  int index = hitBox.size();
+  hitBox.push_back(current);
+
+  if (spheres.size() == 1) {
+    hitBox[index].center = spheres[0].center;
+    hitBox[index].bias = glm::vec3(spheres[0].radius, spheres[0].radius, spheres[0].radius);
+    hitBox[index].left = -1;
+    hitBox[index].right = -1;
+    hitBox[index].sphere = spheres[0].index;
+  } else {
+    int axis = _engine() % 3;
+    if (axis == 0) {
+      std::sort(spheres.begin(), spheres.end(), [](UniformSphere& left, UniformSphere& right) {
+        return (left.center - left.radius).x < (right.center - right.radius).x;
+      });
+    } else if (axis == 1) {
+      std::sort(spheres.begin(), spheres.end(), [](UniformSphere& left, UniformSphere& right) {
+        return (left.center - left.radius).y < (right.center - right.radius).y;
+      });
+    } else {
+      std::sort(spheres.begin(), spheres.end(), [](UniformSphere& left, UniformSphere& right) {
+        return (left.center - left.radius).z < (right.center - right.radius).z;
+      });
+    }
+
+    int mid = spheres.size() / 2;
+    auto left = _calculateHitbox(std::vector<UniformSphere>(spheres.begin(), spheres.begin() + mid), hitBox, index);
+    auto right = _calculateHitbox(std::vector<UniformSphere>(spheres.begin() + mid, spheres.end()), hitBox, index);
+    hitBox[index] = mergeHitBoxes(hitBox, left, right);
+    hitBox[index].left = left;
+    hitBox[index].right = right;
+    hitBox[index].sphere = -1;
+  }
+
+  hitBox[index].index = index;
+  hitBox[index].parent = parent;
+
+  return index;
+}
+
+// lights are split by the median along the longest axis of their centers, so nearby lights share nodes and
+// importance of the node bounds is tight
+int calculateLightTree(std::vector<UniformSphere> lights, std::vector<LightNode>& nodes, int parent) {
+  int index = nodes.size();
+  nodes.push_back(LightNode{});
+  nodes[index].parent = parent;
+
+  if (lights.size() == 1) {
+    auto light = lights[0];
+    nodes[index].min = light.center - light.radius;
+    nodes[index].max = light.center + light.radius;
+    float luminance = glm::dot(light.material.attenuation, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+    // sphere of constant radiance L emits pi * L * area
+    nodes[index].power = glm::pi<float>() * luminance * 4.f * glm::pi<float>() * light.radius * light.radius;
+    nodes[index].left = -1;
+    nodes[index].right = -1;
+    nodes[index].light = light.index;
+    return index;
+  }
+
+  glm::vec3 minCenter = lights[0].center, maxCenter = lights[0].center;
+  for (auto& light : lights) {
+    minCenter = glm::min(minCenter, light.center);
+    maxCenter = glm::max(maxCenter, light.center);
+  }
+  glm::vec3 size = maxCenter - minCenter;
+  int axis = 0;
+  if (size.y > size[axis]) axis = 1;
+  if (size.z > size[axis]) axis = 2;
+  std::sort(lights.begin(), lights.end(),
+            [axis](UniformSphere& left, UniformSphere& right) { return left.center[axis] < right.center[axis]; });
+
+  int mid = lights.size() / 2;
+  auto left = calculateLightTree(std::vector<UniformSphere>(lights.begin(), lights.begin() + mid), nodes, index);
+  auto right = calculateLightTree(std::vector<UniformSphere>(lights.begin() + mid, lights.end()), nodes, index);
+  nodes[index].min = glm::min(nodes[left].min, nodes[right].min);
+  nodes[index].max = glm::max(nodes[left].max, nodes[right].max);
+  nodes[index].power = nodes[left].power + nodes[right].power;
+  nodes[index].left = left;
+  nodes[index].right = right;
+  nodes[index].light = -1;
+  return index;
+}
+
+Scene::Scene(uint32_t seed) : _engine(seed) {
+  std::uniform_real_distribution<> dist(0, 1);
+  std::uniform_real_distribution<> dist2(0, 0.5);
+  std::uniform_real_distribution<> dist3(0.5, 1);
+
+  int current = 0;
+  {
+    UniformSphere sphere{};
+    sphere.center = glm::vec3(0.f, -1000.f, 0.f);
+    sphere.radius = 1000.f;
+    sphere.index = current;
+    UniformMaterial material{};
+    material.type = MATERIAL_DIFFUSE;
+    material.attenuation = glm::vec3(0.5, 0.5, 0.5);
+    material.fuzz = 0;
+    material.refraction = 1;
+    sphere.material = material;
+    _spheres.spheres[current++] = sphere;
+  }
+  for (int a = -4; a < 4; a++) {
+    for (int b = -4; b < 4; b++) {
+      float chooseMat = dist(_engine);
+      glm::vec3 center(a + 0.9 * dist(_engine), 0.2, b + 0.9 * dist(_engine));
+
+      if ((center - glm::vec3(4, 0.2, 0)).length() > 0.9) {
+        if (chooseMat < 0.8) {
+          // diffuse
+          auto albedo = glm::vec3(dist(_engine), dist(_engine), dist(_engine));
+          {
+            UniformSphere sphere{};
+            sphere.center = center;
+            sphere.radius = 0.2;
+            sphere.index = current;
+            UniformMaterial material{};
+            material.type = MATERIAL_DIFFUSE;
+            material.attenuation = albedo;
+            material.fuzz = 0;
+            material.refraction = 1;
+            sphere.material = material;
+            _spheres.spheres[current++] = sphere;
+          }
+        } else if (chooseMat < 0.95) {
+          // metal
+          auto albedo = glm::vec3(dist3(_engine), dist3(_engine), dist3(_engine));
+          auto fuzz = dist2(_engine);
+          {
+            UniformSphere sphere{};
+            sphere.center = center;
+            sphere.radius = 0.2;
+            sphere.index = current;
+            UniformMaterial material{};
+            material.type = MATERIAL_METAL;
+            material.attenuation = albedo;
+            material.fuzz = fuzz;
+            material.refraction = 1;
+            sphere.material = material;
+            _spheres.spheres[current++] = sphere;
+          }
+        } else {
+          // glass
+          {
+            UniformSphere sphere{};
+            sphere.center = center;
+            sphere.radius = 0.2;
+            sphere.index = current;
+            UniformMaterial material{};
+            material.type = MATERIAL_DIELECTRIC;
+            material.attenuation = glm::vec3(1.f, 1.f, 1.f);
+            material.fuzz = 0;
+            material.refraction = 1.f / 1.5f;
+            sphere.material = material;
+            _spheres.spheres[current++] = sphere;
+          }
+        }
+      }
+    }
+  }
+  {
+    UniformSphere sphere{};
+    sphere.center = glm::vec3(0, 1, 0);
+    sphere.radius = 1.0;
+    sphere.index = current;
+    UniformMaterial material{};
+    material.type = MATERIAL_DIELECTRIC;
+    material.attenuation = glm::vec3(1.f, 1.f, 1.f);
+    material.fuzz = 0;
+    material.refraction = 1.f / 1.5f;
+    sphere.material = material;
+    _spheres.spheres[current++] = sphere;
+  }
+  {
+    UniformSphere sphere{};
+    sphere.center = glm::vec3(-4, 1, 0);
+    sphere.radius = 1.0;
+    sphere.index = current;
+    UniformMaterial material{};
+    material.type = MATERIAL_DIFFUSE;
+    material.attenuation = glm::vec3(0.4f, 0.2f, 0.1f);
+    material.fuzz = 0;
+    material.refraction = 1.f;
+    sphere.material = material;
+    _spheres.spheres[current++] = sphere;
+  }
+  {
+    UniformSphere sphere{};
+    sphere.center = glm::vec3(4, 1, 0);
+    sphere.radius = 1.0;
+    sphere.index = current;
+    UniformMaterial material{};
+    material.type = MATERIAL_METAL;
+    material.attenuation = glm::vec3(0.7f, 0.6f, 0.5f);
+    material.fuzz = 0;
+    material.refraction = 1.f;
+    sphere.material = material;
+    _spheres.spheres[current++] = sphere;
+  }
+
+  // lights, attenuation of emissive material is emitted radiance
+  {
+    UniformSphere sphere{};
+    sphere.center = glm::vec3(-2, 3.5, 1);
+    sphere.radius = 0.5;
+    sphere.index = current;
+    UniformMaterial material{};
+    material.type = MATERIAL_EMISSIVE;
+    material.attenuation = glm::vec3(8.f, 7.f, 6.f);
+    material.fuzz = 0;
+    material.refraction = 1.f;
+    sphere.material = material;
+    _spheres.spheres[current++] = sphere;
+  }
+  {
+    UniformSphere sphere{};
+    sphere.center = glm::vec3(3, 2.5, 2);
+    sphere.radius = 0.3;
+    sphere.index = current;
+    UniformMaterial material{};
+    material.type = MATERIAL_EMISSIVE;
+    material.attenuation = glm::vec3(2.f, 4.f, 8.f);
+    material.fuzz = 0;
+    material.refraction = 1.f;
+    sphere.material = material;
+    _spheres.spheres[current++] = sphere;
+  }
+
+  // many small dim lights between the spheres, uniform light selection wastes most samples on distant ones
+  for (int a = -4; a < 4; a++) {
+    for (int b = -4; b < 4; b += 2) {
+      UniformSphere sphere{};
+      sphere.center = glm::vec3(a + dist(_engine), 0.05, b + 2 * dist(_engine));
+      sphere.radius = 0.05;
+      sphere.index = current;
+      UniformMaterial material{};
+      material.type = MATERIAL_EMISSIVE;
+      material.attenuation = glm::vec3(dist3(_engine), dist3(_engine), dist3(_engine)) * 20.f;
+      material.fuzz = 0;
+      material.refraction = 1.f;
+      sphere.material = material;
+      _spheres.spheres[current++] = sphere;
+    }
+  }
+
+  _spheres.number = current;
+
+  _lights = {0};
+  std::vector<UniformSphere> lightSpheres;
+  for (int i = 0; i < _spheres.number; i++) {
+    _spheres.spheres[i].lightNode = -1;
+    if (_spheres.spheres[i].material.type == MATERIAL_EMISSIVE) {
+      _lights.push_back(i);
+      lightSpheres.push_back(_spheres.spheres[i]);
+    }
+  }
+  _lights[0] = _lights.size() - 1;
+
+  if (lightSpheres.size() > 0) {
+    calculateLightTree(lightSpheres, _lightTree, -1);
+    for (int i = 0; i < _lightTree.size(); i++) {
+      if (_lightTree[i].light != -1) _spheres.spheres[_lightTree[i].light].lightNode = i;
+    }
+  } else {
+    // storage buffer can't be empty, tree is never read without lights
+    _lightTree.push_back(LightNode{});
+  }
+
+  std::vector<HitBoxTemp> hitboxTemp;
+  _calculateHitbox(std::vector<UniformSphere>(_spheres.spheres, _spheres.spheres + _spheres.number), hitboxTemp, -1);
+  _hitboxes.number = hitboxTemp.size();
+  calculateThreadedBVH(hitboxTemp, _hitboxes);
+}
+
+UniformSpheres& Scene::getSpheres() { return _spheres; }
+
+UniformHitBox& Scene::getHitboxes() { return _hitboxes; }
+
+std::vector<int>& Scene::getLights() { return _lights; }
+
+std::vector<LightNode>& Scene::getLightTree() { return _lightTree; }
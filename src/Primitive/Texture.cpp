@@ -45,6 +45,20 @@ Texture::Texture(std::shared_ptr<ImageView> imageView, std::shared_ptr<Device> d
   _sampler = std::make_shared<Sampler>(device);
 }
 
+Texture::Texture(std::tuple<int, int> resolution,
+                 VkFormat format,
+                 VkImageUsageFlags usage,
+                 std::shared_ptr<CommandPool> commandPool,
+                 std::shared_ptr<Queue> queue,
+                 std::shared_ptr<Device> device) {
+  _device = device;
+  auto image = std::make_shared<Image>(resolution, format, VK_IMAGE_TILING_OPTIMAL, usage,
+                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device);
+  image->changeLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, commandPool, queue);
+  _imageView = std::make_shared<ImageView>(image, VK_IMAGE_ASPECT_COLOR_BIT, device);
+  _sampler = std::make_shared<Sampler>(device);
+}
+
 std::shared_ptr<ImageView> Texture::getImageView() { return _imageView; }
 
 std::shared_ptr<Sampler> Texture::getSampler() { return _sampler; }
\ No newline at end of file
@@ -103,6 +103,36 @@ void GUI::addCheckbox(std::string name,
   _calls++;
 }
 
+void GUI::addSlider(std::string name,
+                    std::tuple<int, int> position,
+                    std::tuple<int, int> size,
+                    std::map<std::string, std::tuple<int*, int, int>> variable) {
+  if (_calls == 0) ImGui::NewFrame();
+  for (auto& [key, value] : variable) {
+    ImGui::SetNextWindowPos(ImVec2(std::get<0>(position), std::get<1>(position)), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(std::get<0>(size), std::get<1>(size)), ImGuiCond_FirstUseEver);
+    ImGui::Begin(name.c_str());
+    ImGui::SliderInt(key.c_str(), std::get<0>(value), std::get<1>(value), std::get<2>(value));
+    ImGui::End();
+  }
+  _calls++;
+}
+
+void GUI::addSlider(std::string name,
+                    std::tuple<int, int> position,
+                    std::tuple<int, int> size,
+                    std::map<std::string, std::tuple<float*, float, float>> variable) {
+  if (_calls == 0) ImGui::NewFrame();
+  for (auto& [key, value] : variable) {
+    ImGui::SetNextWindowPos(ImVec2(std::get<0>(position), std::get<1>(position)), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(std::get<0>(size), std::get<1>(size)), ImGuiCond_FirstUseEver);
+    ImGui::Begin(name.c_str());
+    ImGui::SliderFloat(key.c_str(), std::get<0>(value), std::get<1>(value), std::get<2>(value));
+    ImGui::End();
+  }
+  _calls++;
+}
+
 void GUI::addText(std::string name,
                   std::tuple<int, int> position,
                   std::tuple<int, int> size,
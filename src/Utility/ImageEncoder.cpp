@@ -0,0 +1,647 @@
+#include "ImageEncoder.h"
+#include "ImageWriter.h"
+#include <glm/gtc/packing.hpp>
+#include <fstream>
+#include <array>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <climits>
+
+// deflate (RFC 1951): LZ77 over the band with hash chains, then dynamic Huffman blocks
+constexpr int windowSize = 32768;
+constexpr int hashBits = 15;
+// longer chains compress a bit better, but noisy renders rarely have long repeats and search time grows fast
+constexpr int maxChain = 8;
+constexpr int minMatch = 3;
+constexpr int maxMatch = 258;
+constexpr int blockTokens = 1 << 15;
+// about 128 KB of raw bytes per PNG band, big enough for matches and small enough to keep every thread busy
+constexpr int bandBytes = 1 << 17;
+// EXR ZIP compression always packs 16 scanlines into a block
+constexpr int exrBlockLines = 16;
+
+constexpr uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                     31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t distanceBase[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                       33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                       1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr uint8_t codeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// match tokens have the top bit set, length and distance are packed below it
+constexpr uint32_t matchBit = 1u << 31;
+
+class BitWriter {
+ private:
+  std::vector<uint8_t>& _out;
+  uint64_t _bits = 0;
+  int _count = 0;
+
+ public:
+  BitWriter(std::vector<uint8_t>& out) : _out(out) {}
+  // deflate packs values starting from the least significant bit
+  void write(uint32_t value, int count) {
+    _bits |= static_cast<uint64_t>(value) << _count;
+    _count += count;
+    while (_count >= 8) {
+      _out.push_back(_bits & 0xFF);
+      _bits >>= 8;
+      _count -= 8;
+    }
+  }
+  void align() {
+    if (_count > 0) write(0, 8 - _count);
+  }
+};
+
+static const std::array<uint8_t, maxMatch + 1>& lengthSymbols() {
+  static const auto table = [] {
+    std::array<uint8_t, maxMatch + 1> table{};
+    for (int symbol = 0; symbol < 29; symbol++) {
+      int end = symbol == 28 ? maxMatch + 1 : lengthBase[symbol + 1];
+      for (int length = lengthBase[symbol]; length < end; length++) table[length] = symbol;
+    }
+    return table;
+  }();
+  return table;
+}
+
+static const std::vector<uint8_t>& distanceSymbols() {
+  static const auto table = [] {
+    std::vector<uint8_t> table(windowSize + 1);
+    for (int symbol = 0; symbol < 30; symbol++) {
+      int end = symbol == 29 ? windowSize + 1 : distanceBase[symbol + 1];
+      for (int distance = distanceBase[symbol]; distance < end; distance++) table[distance] = symbol;
+    }
+    return table;
+  }();
+  return table;
+}
+
+// Huffman code lengths limited to maxBits, zero for unused symbols
+static void buildLengths(const uint32_t* frequencies, int count, int maxBits, uint8_t* lengths) {
+  std::fill(lengths, lengths + count, 0);
+  std::vector<std::tuple<uint32_t, int>> symbols;
+  for (int i = 0; i < count; i++)
+    if (frequencies[i] > 0) symbols.push_back({frequencies[i], i});
+  if (symbols.empty()) return;
+  if (symbols.size() == 1) {
+    lengths[std::get<1>(symbols[0])] = 1;
+    return;
+  }
+  std::sort(symbols.begin(), symbols.end());
+
+  // depths of the plain Huffman tree, leaves are nodes [0, size)
+  int leaves = symbols.size();
+  std::vector<int> parent(2 * leaves - 1, -1);
+  using Node = std::tuple<uint64_t, int>;
+  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+  for (int i = 0; i < leaves; i++) queue.push({std::get<0>(symbols[i]), i});
+  for (int next = leaves; queue.size() > 1; next++) {
+    auto [weightA, a] = queue.top();
+    queue.pop();
+    auto [weightB, b] = queue.top();
+    queue.pop();
+    parent[a] = parent[b] = next;
+    queue.push({weightA + weightB, next});
+  }
+  std::vector<int> codes(maxBits + 1, 0);
+  for (int i = 0; i < leaves; i++) {
+    int depth = 0;
+    for (int node = i; parent[node] >= 0; node = parent[node]) depth++;
+    codes[std::min(depth, maxBits)]++;
+  }
+
+  // too deep leaves were moved to maxBits, split shorter codes until the code is complete again
+  uint32_t total = 0;
+  for (int bits = maxBits; bits > 0; bits--) total += codes[bits] << (maxBits - bits);
+  while (total != (1u << maxBits)) {
+    codes[maxBits]--;
+    for (int bits = maxBits - 1; bits > 0; bits--) {
+      if (codes[bits] > 0) {
+        codes[bits]--;
+        codes[bits + 1] += 2;
+        break;
+      }
+    }
+    total--;
+  }
+
+  // the rarest symbols get the longest codes
+  int symbol = 0;
+  for (int bits = maxBits; bits > 0; bits--)
+    for (int i = 0; i < codes[bits]; i++) lengths[std::get<1>(symbols[symbol++])] = bits;
+}
+
+// canonical codes, bit reversed, so they can be written starting from the least significant bit
+static void buildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+  int lengthCount[16] = {};
+  for (int i = 0; i < count; i++) lengthCount[lengths[i]]++;
+  lengthCount[0] = 0;
+  int next[16] = {};
+  int code = 0;
+  for (int bits = 1; bits < 16; bits++) {
+    code = (code + lengthCount[bits - 1]) << 1;
+    next[bits] = code;
+  }
+  for (int i = 0; i < count; i++) {
+    if (lengths[i] == 0) continue;
+    int value = next[lengths[i]]++;
+    int reversed = 0;
+    for (int bit = 0; bit < lengths[i]; bit++) reversed |= ((value >> bit) & 1) << (lengths[i] - 1 - bit);
+    codes[i] = reversed;
+  }
+}
+
+static void writeBlock(BitWriter& writer, const uint32_t* tokens, int count, bool final) {
+  auto& lengthSymbol = lengthSymbols();
+  auto& distanceSymbol = distanceSymbols();
+  uint32_t literalFrequencies[286] = {}, distanceFrequencies[30] = {};
+  for (int i = 0; i < count; i++) {
+    uint32_t token = tokens[i];
+    if (token & matchBit) {
+      literalFrequencies[257 + lengthSymbol[(token >> 16) & 0x1FF]]++;
+      distanceFrequencies[distanceSymbol[token & 0xFFFF]]++;
+    } else {
+      literalFrequencies[token]++;
+    }
+  }
+  literalFrequencies[256] = 1;
+
+  uint8_t lengths[286 + 30];
+  uint8_t* literalLengths = lengths;
+  uint8_t distanceLengths[30];
+  buildLengths(literalFrequencies, 286, 15, literalLengths);
+  buildLengths(distanceFrequencies, 30, 15, distanceLengths);
+  // block without matches still has to describe one distance code
+  if (std::all_of(distanceLengths, distanceLengths + 30, [](uint8_t length) { return length == 0; }))
+    distanceLengths[0] = 1;
+  int literalCount = 286, distanceCount = 30;
+  while (literalCount > 257 && literalLengths[literalCount - 1] == 0) literalCount--;
+  while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0) distanceCount--;
+  std::copy(distanceLengths, distanceLengths + distanceCount, lengths + literalCount);
+  int lengthCount = literalCount + distanceCount;
+
+  // both code lengths are run length encoded: 16 repeats previous length, 17 and 18 repeat zeros
+  std::vector<std::tuple<int, int, int>> runs;
+  for (int i = 0; i < lengthCount;) {
+    int length = lengths[i];
+    int run = 1;
+    while (i + run < lengthCount && lengths[i + run] == length) run++;
+    i += run;
+    if (length == 0) {
+      while (run >= 11) {
+        int part = std::min(run, 138);
+        runs.push_back({18, part - 11, 7});
+        run -= part;
+      }
+      if (run >= 3) {
+        runs.push_back({17, run - 3, 3});
+        run = 0;
+      }
+    } else {
+      runs.push_back({length, 0, 0});
+      run--;
+      while (run >= 3) {
+        int part = std::min(run, 6);
+        runs.push_back({16, part - 3, 2});
+        run -= part;
+      }
+    }
+    for (; run > 0; run--) runs.push_back({length, 0, 0});
+  }
+  uint32_t codeLengthFrequencies[19] = {};
+  for (auto& [symbol, extra, bits] : runs) codeLengthFrequencies[symbol]++;
+  uint8_t codeLengthLengths[19];
+  uint16_t codeLengthCodes[19];
+  buildLengths(codeLengthFrequencies, 19, 7, codeLengthLengths);
+  buildCodes(codeLengthLengths, 19, codeLengthCodes);
+  int codeLengthCount = 19;
+  while (codeLengthCount > 4 && codeLengthLengths[codeLengthOrder[codeLengthCount - 1]] == 0) codeLengthCount--;
+
+  writer.write(final ? 1 : 0, 1);
+  writer.write(2, 2);
+  writer.write(literalCount - 257, 5);
+  writer.write(distanceCount - 1, 5);
+  writer.write(codeLengthCount - 4, 4);
+  for (int i = 0; i < codeLengthCount; i++) writer.write(codeLengthLengths[codeLengthOrder[i]], 3);
+  for (auto& [symbol, extra, bits] : runs) {
+    writer.write(codeLengthCodes[symbol], codeLengthLengths[symbol]);
+    if (bits > 0) writer.write(extra, bits);
+  }
+
+  uint16_t literalCodes[286] = {}, distanceCodes[30] = {};
+  buildCodes(literalLengths, literalCount, literalCodes);
+  buildCodes(distanceLengths, distanceCount, distanceCodes);
+  for (int i = 0; i < count; i++) {
+    uint32_t token = tokens[i];
+    if (token & matchBit) {
+      int length = (token >> 16) & 0x1FF;
+      int distance = token & 0xFFFF;
+      int symbol = lengthSymbol[length];
+      writer.write(literalCodes[257 + symbol], literalLengths[257 + symbol]);
+      if (lengthExtra[symbol] > 0) writer.write(length - lengthBase[symbol], lengthExtra[symbol]);
+      symbol = distanceSymbol[distance];
+      writer.write(distanceCodes[symbol], distanceLengths[symbol]);
+      if (distanceExtra[symbol] > 0) writer.write(distance - distanceBase[symbol], distanceExtra[symbol]);
+    } else {
+      writer.write(literalCodes[token], literalLengths[token]);
+    }
+  }
+  writer.write(literalCodes[256], literalLengths[256]);
+}
+
+// appends deflate stream of data; not final stream ends with empty stored block, so it's byte aligned and the next
+// stream can be appended right after it, matches never reach into previous data, so streams are independent
+static void deflate(const uint8_t* data,
+                    int size,
+                    bool final,
+                    std::vector<int32_t>& head,
+                    std::vector<int32_t>& chain,
+                    std::vector<uint32_t>& tokens,
+                    std::vector<uint8_t>& out) {
+  head.assign(1 << hashBits, -1);
+  chain.resize(size);
+  tokens.clear();
+  auto hash = [&](int i) {
+    uint32_t value = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+    return (value * 2654435761u) >> (32 - hashBits);
+  };
+  auto insert = [&](int i) {
+    if (i + minMatch > size) return;
+    uint32_t key = hash(i);
+    chain[i] = head[key];
+    head[key] = i;
+  };
+
+  for (int i = 0; i < size;) {
+    int bestLength = 0, bestDistance = 0;
+    if (i + minMatch <= size) {
+      int limit = std::min(maxMatch, size - i);
+      int candidate = head[hash(i)];
+      for (int steps = 0; candidate >= 0 && i - candidate <= windowSize && steps < maxChain; steps++) {
+        // the byte after the best match so far has to match, otherwise candidate can't be longer
+        if (data[candidate + bestLength] == data[i + bestLength]) {
+          int length = 0;
+          while (length < limit && data[candidate + length] == data[i + length]) length++;
+          if (length > bestLength) {
+            bestLength = length;
+            bestDistance = i - candidate;
+            if (length == limit) break;
+          }
+        }
+        candidate = chain[candidate];
+      }
+    }
+    if (bestLength >= minMatch) {
+      tokens.push_back(matchBit | (bestLength << 16) | bestDistance);
+      for (int j = 0; j < bestLength; j++) insert(i + j);
+      i += bestLength;
+    } else {
+      tokens.push_back(data[i]);
+      insert(i);
+      i++;
+    }
+  }
+
+  BitWriter writer(out);
+  int blocks = std::max(1, static_cast<int>((tokens.size() + blockTokens - 1) / blockTokens));
+  for (int block = 0; block < blocks; block++) {
+    int begin = block * blockTokens;
+    int count = std::min(blockTokens, static_cast<int>(tokens.size()) - begin);
+    writeBlock(writer, tokens.data() + begin, count, final && block == blocks - 1);
+  }
+  if (final == false) {
+    writer.write(0, 1);
+    writer.write(0, 2);
+    writer.align();
+    out.insert(out.end(), {0x00, 0x00, 0xFF, 0xFF});
+  }
+  writer.align();
+}
+
+static uint32_t adler32(const uint8_t* data, size_t size) {
+  uint32_t a = 1, b = 0;
+  // 5552 is the most bytes before 32 bit sums can overflow
+  while (size > 0) {
+    size_t part = std::min<size_t>(size, 5552);
+    size -= part;
+    for (size_t i = 0; i < part; i++) {
+      a += data[i];
+      b += a;
+    }
+    data += part;
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+// adler of concatenation from adlers of both parts, the same as adler32_combine of zlib
+static uint32_t combineAdler32(uint32_t first, uint32_t second, size_t secondSize) {
+  const uint32_t base = 65521;
+  uint32_t remainder = secondSize % base;
+  uint32_t sum1 = first & 0xFFFF;
+  uint32_t sum2 = (remainder * sum1) % base;
+  sum1 += (second & 0xFFFF) + base - 1;
+  sum2 += ((first >> 16) & 0xFFFF) + ((second >> 16) & 0xFFFF) + base - remainder;
+  if (sum1 >= base) sum1 -= base;
+  if (sum1 >= base) sum1 -= base;
+  if (sum2 >= (base << 1)) sum2 -= (base << 1);
+  if (sum2 >= base) sum2 -= base;
+  return sum1 | (sum2 << 16);
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+  static const auto table = [] {
+    std::array<uint32_t, 256> table;
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t value = i;
+      for (int bit = 0; bit < 8; bit++) value = (value & 1) ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+      table[i] = value;
+    }
+    return table;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+// values are written little endian like in PFM and EXR, PNG ones are swapped explicitly
+template <class T>
+static void append(std::vector<uint8_t>& data, T value) {
+  auto bytes = reinterpret_cast<const uint8_t*>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+static void appendBigEndian(std::vector<uint8_t>& data, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) data.push_back((value >> shift) & 0xFF);
+}
+
+static uint32_t chunkCRC(const char* type, const std::vector<uint8_t>& payload) {
+  return crc32(payload.data(), payload.size(), crc32(reinterpret_cast<const uint8_t*>(type), 4));
+}
+
+static void writeChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& payload, uint32_t crc) {
+  std::vector<uint8_t> header;
+  appendBigEndian(header, payload.size());
+  header.insert(header.end(), type, type + 4);
+  file.write(reinterpret_cast<const char*>(header.data()), header.size());
+  file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+  header.clear();
+  appendBigEndian(header, crc);
+  file.write(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+// linear values where rounded sRGB code changes, search of 255 of them is much cheaper than pow for every channel
+static uint8_t toSRGB(float value) {
+  static const auto thresholds = [] {
+    std::array<float, 255> thresholds;
+    for (int code = 0; code < 255; code++) {
+      float encoded = (code + 0.5f) / 255.f;
+      thresholds[code] = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+    }
+    return thresholds;
+  }();
+  return std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin();
+}
+
+ImageEncoder::ImageEncoder(std::shared_ptr<TileScheduler> scheduler) {
+  _scheduler = scheduler;
+  _scratch.resize(scheduler ? scheduler->getThreads() : 1);
+}
+
+void ImageEncoder::_run(std::vector<Tile> tiles, std::function<void(int worker, Tile tile)> task) {
+  if (_scheduler) {
+    _scheduler->run(tiles, task);
+  } else {
+    for (auto& tile : tiles) task(0, tile);
+  }
+}
+
+void ImageEncoder::_encodePNGBand(Scratch& scratch,
+                                  Chunk& chunk,
+                                  Tile tile,
+                                  bool first,
+                                  bool last,
+                                  const std::vector<glm::vec4>& pixels) {
+  int rowBytes = tile.width * 3;
+  auto convert = [&](int y, std::vector<uint8_t>& row) {
+    for (int x = 0; x < tile.width; x++) {
+      auto& pixel = pixels[y * tile.width + x];
+      row[x * 3 + 0] = toSRGB(pixel.x);
+      row[x * 3 + 1] = toSRGB(pixel.y);
+      row[x * 3 + 2] = toSRGB(pixel.z);
+    }
+  };
+  scratch.row.resize(rowBytes);
+  scratch.previousRow.assign(rowBytes, 0);
+  scratch.candidates.resize(5 * rowBytes);
+  scratch.bytes.clear();
+  // filters of the first row of the band look at the last row of the previous band
+  if (tile.y > 0) convert(tile.y - 1, scratch.previousRow);
+
+  for (int y = tile.y; y < tile.y + tile.height; y++) {
+    convert(y, scratch.row);
+    auto& row = scratch.row;
+    auto& up = scratch.previousRow;
+    // none, sub, up, average, Paeth; the one with the smallest sum of signed residuals wins, like in libpng
+    auto paeth = [](int left, int up, int upLeft) {
+      int estimate = left + up - upLeft;
+      int distanceLeft = std::abs(estimate - left);
+      int distanceUp = std::abs(estimate - up);
+      int distanceUpLeft = std::abs(estimate - upLeft);
+      if (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft) return left;
+      return distanceUp <= distanceUpLeft ? up : upLeft;
+    };
+    uint8_t* candidates[5];
+    for (int filter = 0; filter < 5; filter++) candidates[filter] = scratch.candidates.data() + filter * rowBytes;
+    for (int i = 0; i < rowBytes; i++) {
+      int left = i >= 3 ? row[i - 3] : 0;
+      int upLeft = i >= 3 ? up[i - 3] : 0;
+      candidates[0][i] = row[i];
+      candidates[1][i] = row[i] - left;
+      candidates[2][i] = row[i] - up[i];
+      candidates[3][i] = row[i] - (left + up[i]) / 2;
+      candidates[4][i] = row[i] - paeth(left, up[i], upLeft);
+    }
+    int best = 0;
+    int bestSum = INT_MAX;
+    for (int filter = 0; filter < 5; filter++) {
+      int sum = 0;
+      for (int i = 0; i < rowBytes; i++) sum += std::abs(static_cast<int8_t>(candidates[filter][i]));
+      if (sum < bestSum) {
+        bestSum = sum;
+        best = filter;
+      }
+    }
+    scratch.bytes.push_back(best);
+    auto candidate = scratch.candidates.begin() + best * rowBytes;
+    scratch.bytes.insert(scratch.bytes.end(), candidate, candidate + rowBytes);
+    std::swap(scratch.row, scratch.previousRow);
+  }
+
+  chunk.data.clear();
+  // zlib header: deflate with 32K window, no dictionary
+  if (first) chunk.data.insert(chunk.data.end(), {0x78, 0x01});
+  deflate(scratch.bytes.data(), scratch.bytes.size(), last, scratch.head, scratch.chain, scratch.tokens, chunk.data);
+  chunk.adler = adler32(scratch.bytes.data(), scratch.bytes.size());
+  // the last band gets adler of the whole stream appended later
+  if (last == false) chunk.crc = chunkCRC("IDAT", chunk.data);
+}
+
+void ImageEncoder::savePNG(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution) {
+  auto [width, height] = resolution;
+  std::ofstream file(path, std::ios::binary);
+  if (file.is_open() == false) throw std::runtime_error("failed to open " + path + " for writing!");
+
+  int bandRows = std::max(1, bandBytes / (width * 3 + 1));
+  std::vector<Tile> bands;
+  for (int y = 0; y < height; y += bandRows) bands.push_back({0, y, width, std::min(bandRows, height - y)});
+  _chunks.resize(bands.size());
+  _run(bands, [&](int worker, Tile tile) {
+    int index = tile.y / bandRows;
+    _encodePNGBand(_scratch[worker], _chunks[index], tile, index == 0, index == bands.size() - 1, pixels);
+  });
+
+  uint32_t adler = _chunks[0].adler;
+  for (int i = 1; i < bands.size(); i++)
+    adler = combineAdler32(adler, _chunks[i].adler, static_cast<size_t>(bands[i].height) * (width * 3 + 1));
+  auto& last = _chunks[bands.size() - 1];
+  appendBigEndian(last.data, adler);
+  last.crc = chunkCRC("IDAT", last.data);
+
+  const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+  _header.clear();
+  appendBigEndian(_header, width);
+  appendBigEndian(_header, height);
+  // 8 bit RGB, deflate, adaptive filtering, no interlace
+  _header.insert(_header.end(), {8, 2, 0, 0, 0});
+  writeChunk(file, "IHDR", _header, chunkCRC("IHDR", _header));
+  // every band is its own IDAT chunk, readers join them into one zlib stream
+  for (int i = 0; i < bands.size(); i++) writeChunk(file, "IDAT", _chunks[i].data, _chunks[i].crc);
+  _header.clear();
+  writeChunk(file, "IEND", _header, chunkCRC("IEND", _header));
+  if (file.good() == false) throw std::runtime_error("failed to write " + path + "!");
+}
+
+void ImageEncoder::_encodeEXRBlock(Scratch& scratch, Chunk& chunk, Tile tile, const std::vector<glm::vec4>& pixels) {
+  // scanlines one after another, every one has channels B, G, R one after another
+  scratch.bytes.clear();
+  for (int y = tile.y; y < tile.y + tile.height; y++) {
+    for (int channel = 2; channel >= 0; channel--) {
+      for (int x = 0; x < tile.width; x++) append(scratch.bytes, glm::packHalf1x16(pixels[y * tile.width + x][channel]));
+    }
+  }
+
+  // ZIP predictor of OpenEXR: even bytes go to the first half, odd to the second, then bytes are delta coded
+  int size = scratch.bytes.size();
+  scratch.reordered.resize(size);
+  for (int i = 0; i < size; i++) scratch.reordered[(i & 1) ? (size + 1) / 2 + i / 2 : i / 2] = scratch.bytes[i];
+  int previous = scratch.reordered[0];
+  for (int i = 1; i < size; i++) {
+    int current = scratch.reordered[i];
+    scratch.reordered[i] = static_cast<uint8_t>(current - previous + (128 + 256));
+    previous = current;
+  }
+
+  chunk.data.clear();
+  append(chunk.data, static_cast<int32_t>(tile.y));
+  append(chunk.data, static_cast<int32_t>(0));
+  chunk.data.insert(chunk.data.end(), {0x78, 0x01});
+  deflate(scratch.reordered.data(), size, true, scratch.head, scratch.chain, scratch.tokens, chunk.data);
+  appendBigEndian(chunk.data, adler32(scratch.reordered.data(), size));
+  // readers take block of the uncompressed size as stored
+  if (chunk.data.size() - 8 >= size) {
+    chunk.data.resize(8);
+    chunk.data.insert(chunk.data.end(), scratch.bytes.begin(), scratch.bytes.end());
+  }
+  int32_t dataSize = chunk.data.size() - 8;
+  std::copy_n(reinterpret_cast<uint8_t*>(&dataSize), 4, chunk.data.begin() + 4);
+}
+
+static void appendAttribute(std::vector<uint8_t>& header,
+                            std::string name,
+                            std::string type,
+                            const std::vector<uint8_t>& value) {
+  header.insert(header.end(), name.begin(), name.end());
+  header.push_back(0);
+  header.insert(header.end(), type.begin(), type.end());
+  header.push_back(0);
+  append(header, static_cast<int32_t>(value.size()));
+  header.insert(header.end(), value.begin(), value.end());
+}
+
+void ImageEncoder::saveEXR(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution) {
+  auto [width, height] = resolution;
+  std::ofstream file(path, std::ios::binary);
+  if (file.is_open() == false) throw std::runtime_error("failed to open " + path + " for writing!");
+
+  std::vector<Tile> blocks;
+  for (int y = 0; y < height; y += exrBlockLines) blocks.push_back({0, y, width, std::min(exrBlockLines, height - y)});
+  _chunks.resize(blocks.size());
+  _run(blocks, [&](int worker, Tile tile) {
+    _encodeEXRBlock(_scratch[worker], _chunks[tile.y / exrBlockLines], tile, pixels);
+  });
+
+  _header.clear();
+  // magic number and version 2, single part scanline file
+  append(_header, static_cast<uint32_t>(20000630));
+  append(_header, static_cast<uint32_t>(2));
+  // channels must be sorted by name, every one is half with 1x1 sampling
+  std::vector<uint8_t> channels;
+  for (const char* name : {"B", "G", "R"}) {
+    channels.insert(channels.end(), {static_cast<uint8_t>(name[0]), 0});
+    append(channels, static_cast<int32_t>(1));
+    channels.insert(channels.end(), {0, 0, 0, 0});
+    append(channels, static_cast<int32_t>(1));
+    append(channels, static_cast<int32_t>(1));
+  }
+  channels.push_back(0);
+  appendAttribute(_header, "channels", "chlist", channels);
+  // ZIP, 16 scanlines per block
+  appendAttribute(_header, "compression", "compression", {3});
+  std::vector<uint8_t> window;
+  for (int32_t value : {0, 0, width - 1, height - 1}) append(window, value);
+  appendAttribute(_header, "dataWindow", "box2i", window);
+  appendAttribute(_header, "displayWindow", "box2i", window);
+  // increasing y, rows go top to bottom like in result textures
+  appendAttribute(_header, "lineOrder", "lineOrder", {0});
+  std::vector<uint8_t> value;
+  append(value, 1.f);
+  appendAttribute(_header, "pixelAspectRatio", "float", value);
+  appendAttribute(_header, "screenWindowWidth", "float", value);
+  value.clear();
+  append(value, 0.f);
+  append(value, 0.f);
+  appendAttribute(_header, "screenWindowCenter", "v2f", value);
+  _header.push_back(0);
+
+  uint64_t offset = _header.size() + blocks.size() * sizeof(uint64_t);
+  for (int i = 0; i < blocks.size(); i++) {
+    append(_header, offset);
+    offset += _chunks[i].data.size();
+  }
+  file.write(reinterpret_cast<const char*>(_header.data()), _header.size());
+  for (int i = 0; i < blocks.size(); i++)
+    file.write(reinterpret_cast<const char*>(_chunks[i].data.data()), _chunks[i].data.size());
+  if (file.good() == false) throw std::runtime_error("failed to write " + path + "!");
+}
+
+void ImageEncoder::save(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution) {
+  std::string extension = path.substr(path.find_last_of('.') + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  if (extension == "png")
+    savePNG(path, pixels, resolution);
+  else if (extension == "exr")
+    saveEXR(path, pixels, resolution);
+  else if (extension == "pfm")
+    savePFM(path, pixels, resolution);
+  else
+    throw std::runtime_error("unsupported image format of " + path + "!");
+}
\ No newline at end of file
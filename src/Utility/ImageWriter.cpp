@@ -0,0 +1,21 @@
+#include "ImageWriter.h"
+#include <fstream>
+
+void savePFM(std::string path, const std::vector<glm::vec4>& pixels, std::tuple<int, int> resolution) {
+  auto [width, height] = resolution;
+  std::ofstream file(path, std::ios::binary);
+  if (file.is_open() == false) throw std::runtime_error("failed to open " + path + " for writing!");
+  // negative scale means little endian, scanlines go from bottom to top
+  file << "PF\n" << width << " " << height << "\n-1.0\n";
+  std::vector<float> row(width * 3);
+  for (int y = height - 1; y >= 0; y--) {
+    for (int x = 0; x < width; x++) {
+      auto& pixel = pixels[y * width + x];
+      row[x * 3 + 0] = pixel.x;
+      row[x * 3 + 1] = pixel.y;
+      row[x * 3 + 2] = pixel.z;
+    }
+    file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+  }
+  if (file.good() == false) throw std::runtime_error("failed to write " + path + "!");
+}
@@ -0,0 +1,124 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+Profiler::Profiler(std::shared_ptr<Device> device, std::shared_ptr<Settings> settings, int regions) {
+  _device = device;
+  _settings = settings;
+  _regions = regions;
+  // compute and graphic queues are both profiled
+  _supported = device->getDeviceProperties().limits.timestampComputeAndGraphics == VK_TRUE;
+  if (_supported == false) std::cerr << "profiler: timestamps aren't supported, regions aren't measured" << std::endl;
+
+  // begin and end timestamps of every region for every frame slot
+  _queryPool = std::make_shared<QueryPool>(2 * regions * settings->getMaxFramesInFlight(), device);
+  _written.resize(settings->getMaxFramesInFlight());
+  _frames.resize(settings->getMaxFramesInFlight());
+
+  _checkboxes["csv"] = &_enabled;
+}
+
+void Profiler::_write(int frame, std::string name, float time) {
+  if (_file.is_open() == false) {
+    _file.open(_path);
+    if (_file.is_open() == false) throw std::runtime_error("Can't open " + _path);
+    _file << "frame,region,ms" << std::endl;
+  }
+  _file << frame << "," << name << "," << time << "\n";
+}
+
+void Profiler::resolve(int currentFrame) {
+  if (_written[currentFrame].empty()) return;
+
+  std::map<std::string, float> totals;
+  for (int region : _written[currentFrame]) {
+    int first = 2 * (currentFrame * _regions + region);
+    // the fence of the slot is waited, so results are there, the check only guards against a broken frame
+    auto timestamps = _queryPool->getResults(first, 2, false);
+    if (timestamps.has_value() == false) continue;
+
+    float time = _queryPool->getElapsed(timestamps.value()[0], timestamps.value()[1]);
+    totals[_queues[region]] += time;
+    _history[region].push_back(time);
+    if (_history[region].size() > _historySize) _history[region].pop_front();
+    if (_enabled) _write(_frames[currentFrame], _names[region], time);
+  }
+  for (auto& [queue, total] : totals) {
+    _totals[queue].push_back(total);
+    if (_totals[queue].size() > _historySize) _totals[queue].pop_front();
+    if (_enabled) _write(_frames[currentFrame], queue + " total", total);
+  }
+  _written[currentFrame].clear();
+}
+
+void Profiler::reset(VkCommandBuffer commandBuffer, int currentFrame) {
+  if (_supported == false) return;
+  vkCmdResetQueryPool(commandBuffer, _queryPool->getQueryPool(), 2 * currentFrame * _regions, 2 * _regions);
+  _written[currentFrame].clear();
+  _frames[currentFrame] = _frame++;
+}
+
+void Profiler::begin(VkCommandBuffer commandBuffer, int currentFrame, std::string name, std::string queue) {
+  if (_supported == false) return;
+  if (_indices.contains(name) == false) {
+    if (_names.size() == _regions)
+      throw std::runtime_error("profiler: too many regions, " + name + " can't be added");
+    _indices[name] = _names.size();
+    _names.push_back(name);
+    _queues.push_back(queue);
+    _history.push_back({});
+  }
+
+  int region = _indices[name];
+  // every region is written once per frame, otherwise the second write would overwrite the first
+  if (std::find(_written[currentFrame].begin(), _written[currentFrame].end(), region) != _written[currentFrame].end())
+    throw std::runtime_error("profiler: region " + name + " is begun twice in a frame");
+  // like timestamps of the parts, both are written after the previous commands are done
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * (currentFrame * _regions + region));
+  _written[currentFrame].push_back(region);
+  _open.push_back(region);
+}
+
+void Profiler::end(VkCommandBuffer commandBuffer, int currentFrame) {
+  if (_supported == false) return;
+  if (_open.empty()) throw std::runtime_error("profiler: no region to end");
+  int region = _open.back();
+  _open.pop_back();
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool->getQueryPool(),
+                      2 * (currentFrame * _regions + region) + 1);
+}
+
+std::vector<std::string> Profiler::getStatistics() {
+  auto format = [](std::string name, const std::deque<float>& history) {
+    std::stringstream line;
+    line << name << ": ";
+    if (history.empty()) return line.str() + "-";
+    std::vector<float> sorted(history.begin(), history.end());
+    std::sort(sorted.begin(), sorted.end());
+    float average = std::accumulate(sorted.begin(), sorted.end(), 0.f) / sorted.size();
+    // nearest rank percentile
+    int p99 = std::max(0, static_cast<int>(std::ceil(0.99f * sorted.size())) - 1);
+    line << std::fixed << std::setprecision(3) << history.back() << " ms (min " << sorted.front() << ", avg "
+         << average << ", p99 " << sorted[p99] << ")";
+    return line.str();
+  };
+
+  std::vector<std::string> statistics;
+  for (int region = 0; region < _names.size(); region++)
+    statistics.push_back(format(_names[region], _history[region]));
+  for (auto& [queue, total] : _totals) statistics.push_back(format(queue + " total", total));
+  return statistics;
+}
+
+void Profiler::setPath(std::string path) {
+  _path = path;
+  _file.close();
+}
+
+void Profiler::setEnabled(bool enabled) { _enabled = enabled; }
+
+std::map<std::string, bool*> Profiler::getCheckboxes() { return _checkboxes; }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "Sobol.h"
+
+struct SobolParameters {
+  int degree;
+  uint32_t coefficients;
+  std::vector<uint32_t> initial;
+};
+
+// Joe-Kuo direction numbers (new-joe-kuo-6.21201) for dimensions after the first one
+const std::vector<SobolParameters> sobolParameters = {{1, 0, {1}},       {2, 1, {1, 3}},       {3, 1, {1, 3, 1}},
+                                                      {3, 2, {1, 1, 1}}, {4, 1, {1, 1, 3, 3}}, {4, 4, {1, 3, 5, 13}},
+                                                      {5, 2, {1, 1, 5, 5, 17}}};
+
+Sobol::Sobol(int samples, int dimensions) {
+  if (samples <= 0 || dimensions <= 0) throw std::invalid_argument("Sobol table needs samples and dimensions!");
+  if (dimensions > static_cast<int>(sobolParameters.size()) + 1)
+    throw std::invalid_argument("not enough Sobol direction numbers!");
+  _samples = samples;
+  _dimensions = dimensions;
+  _table.resize(samples * dimensions);
+
+  for (int d = 0; d < dimensions; d++) {
+    uint32_t direction[32];
+    if (d == 0) {
+      // first dimension is van der Corput sequence
+      for (int i = 0; i < 32; i++) direction[i] = 1u << (31 - i);
+    } else {
+      auto& parameters = sobolParameters[d - 1];
+      int s = parameters.degree;
+      for (int i = 0; i < s; i++) direction[i] = parameters.initial[i] << (31 - i);
+      for (int i = s; i < 32; i++) {
+        direction[i] = direction[i - s] ^ (direction[i - s] >> s);
+        for (int k = 1; k < s; k++) direction[i] ^= ((parameters.coefficients >> (s - 1 - k)) & 1) * direction[i - k];
+      }
+    }
+
+    for (int i = 0; i < samples; i++) {
+      uint32_t value = 0;
+      for (int bit = 0; bit < 32; bit++) {
+        if ((i >> bit) & 1) value ^= direction[bit];
+      }
+      _table[i * dimensions + d] = value;
+    }
+  }
+}
+
+std::vector<uint32_t>& Sobol::getTable() { return _table; }
+
+int Sobol::getSamples() { return _samples; }
+
+int Sobol::getDimensions() { return _dimensions; }